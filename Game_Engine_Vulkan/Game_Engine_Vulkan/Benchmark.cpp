@@ -0,0 +1,107 @@
+#include "Benchmark.h"
+#include "VulkanSwapChain.h"
+
+// std
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace VulkanEngine {
+	namespace {
+		void writeString(std::ostream& out, const std::string& text) {
+			out << '"';
+			for (char c : text) {
+				if (c == '"' || c == '\\') {
+					out << '\\' << c;
+				}
+				else if (static_cast<unsigned char>(c) >= 0x20) {
+					out << c;
+				}
+			}
+			out << '"';
+		}
+
+		void writeSummary(std::ostream& out, const SampleSummary& summary) {
+			out << "{\"count\": " << summary.count << ", \"mean\": " << summary.mean << ", \"p50\": " << summary.p50
+				<< ", \"p95\": " << summary.p95 << ", \"p99\": " << summary.p99 << ", \"max\": " << summary.max << "}";
+		}
+	}
+
+	void Benchmark::addFrame(double frameMs, double cpuMs)
+	{
+		frameTimes.push_back(frameMs);
+		cpuTimes.push_back(cpuMs);
+	}
+
+	void Benchmark::writeReport(
+		const std::string& path,
+		const EngineConfig& config,
+		const RunInfo& runInfo,
+		const VulkanGpuProfiler& gpuProfiler) const
+	{
+		std::ofstream out{ path, std::ios::trunc };
+		if (!out.is_open()) {
+			throw std::runtime_error("failed to open benchmark report " + path + "!");
+		}
+
+		std::vector<VulkanGpuProfiler::ScopeStats> gpuScopes = gpuProfiler.getStats();
+		auto gpuFrame = std::find_if(gpuScopes.begin(), gpuScopes.end(),
+			[](const VulkanGpuProfiler::ScopeStats& scope) { return scope.name == "Frame"; });
+
+		out << std::fixed << std::setprecision(4);
+		out << "{\n";
+		out << "  \"device\": ";
+		writeString(out, runInfo.deviceName);
+		out << ",\n";
+		out << "  \"frames\": " << frameTimes.size() << ",\n";
+		out << "  \"timestep\": " << config.fixedTimestep << ",\n";
+		out << "  \"cameraPath\": ";
+		writeString(out, config.cameraPath.empty() ? "scripted" : config.cameraPath);
+		out << ",\n";
+		out << "  \"headless\": " << (config.headless ? "true" : "false") << ",\n";
+		out << "  \"presentMode\": ";
+		writeString(out, VulkanSwapChain::presentModeName(runInfo.presentMode));
+		out << ",\n";
+		out << "  \"framesInFlight\": " << runInfo.framesInFlight << ",\n";
+		out << "  \"maxFps\": " << config.maxFps << ",\n";
+		out << "  \"frameTimeMs\": ";
+		writeSummary(out, SampleSummary::of(frameTimes));
+		out << ",\n";
+		out << "  \"cpuTimeMs\": ";
+		writeSummary(out, SampleSummary::of(cpuTimes));
+		out << ",\n";
+		out << "  \"gpuTimeMs\": ";
+		if (gpuFrame != gpuScopes.end()) {
+			writeSummary(out, gpuFrame->ms);
+		}
+		else {
+			out << "null";
+		}
+		out << ",\n";
+		out << "  \"gpuScopesMs\": {";
+		for (size_t i = 0; i < gpuScopes.size(); i++) {
+			out << (i == 0 ? "\n    " : ",\n    ");
+			writeString(out, gpuScopes[i].name);
+			out << ": ";
+			writeSummary(out, gpuScopes[i].ms);
+		}
+		out << (gpuScopes.empty() ? "}\n" : "\n  }\n");
+		out << "}\n";
+
+		if (!out) {
+			throw std::runtime_error("failed to write benchmark report " + path + "!");
+		}
+	}
+
+	void Benchmark::print(std::ostream& out) const
+	{
+		SampleSummary frame = SampleSummary::of(frameTimes);
+		SampleSummary cpu = SampleSummary::of(cpuTimes);
+		out << std::fixed << std::setprecision(3);
+		out << "Benchmark: " << frame.count << " frames, frame time mean " << frame.mean << " ms, p50 " << frame.p50
+			<< ", p95 " << frame.p95 << ", p99 " << frame.p99 << ", max " << frame.max << "; CPU mean " << cpu.mean
+			<< " ms, p99 " << cpu.p99 << "\n";
+		out << std::defaultfloat;
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "EngineConfig.h"
+#include "VulkanGpuProfiler.h"
+
+// std
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace VulkanEngine {
+	// Frame times of a benchmark run (see EngineConfig::benchmark) and the JSON report they end up in
+	class Benchmark {
+	public:
+		/* frameMs is the wall time since the previous frame; cpuMs the part of it not spent waiting
+			on the frame limiter, a frame slot or a swapchain image. */
+		void addFrame(double frameMs, double cpuMs);
+
+		struct RunInfo {
+			std::string deviceName;
+			VkPresentModeKHR presentMode;
+			uint32_t framesInFlight;
+		};
+		// GPU times come from the profiler's scopes, whose history has to cover the whole run
+		void writeReport(
+			const std::string& path,
+			const EngineConfig& config,
+			const RunInfo& runInfo,
+			const VulkanGpuProfiler& gpuProfiler) const;
+		void print(std::ostream& out) const;
+
+	private:
+		std::vector<double> frameTimes;
+		std::vector<double> cpuTimes;
+	};
+}
@@ -0,0 +1,106 @@
+#include "CameraPath.h"
+#include "keyboard_movement_controller.h"
+
+// std
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace VulkanEngine {
+	CameraPath CameraPath::scripted()
+	{
+		using Key = KeyboardMovementController::Key;
+		const Segment script[] = {
+			{ 90, Key::MOVE_FORWARD },
+			{ 60, Key::MOVE_FORWARD | Key::LOOK_RIGHT },
+			{ 90, Key::MOVE_FORWARD },
+			{ 45, Key::LOOK_UP },
+			{ 45, Key::LOOK_DOWN },
+			{ 60, Key::MOVE_LEFT },
+			{ 60, Key::MOVE_BACKWARD | Key::LOOK_LEFT },
+			{ 30, Key::MOVE_UP },
+			{ 30, Key::MOVE_DOWN },
+			{ 60, 0 },
+		};
+		CameraPath path{};
+		for (const Segment& segment : script) {
+			path.segments.push_back(segment);
+			path.totalFrames += segment.frames;
+		}
+		return path;
+	}
+
+	CameraPath CameraPath::load(const std::string& path)
+	{
+		std::ifstream file{ path };
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to open camera path " + path + "!");
+		}
+
+		CameraPath cameraPath{};
+		std::string line;
+		int lineNumber = 0;
+		while (std::getline(file, line)) {
+			lineNumber++;
+			line = line.substr(0, line.find('#'));
+			if (line.find_first_not_of(" \t\r") == std::string::npos) {
+				continue; // blank or comment
+			}
+			std::istringstream fields{ line };
+			long long frames = 0;
+			long long keys = 0;
+			std::string rest;
+			if (!(fields >> frames >> keys) || (fields >> rest) || frames < 0 || frames > UINT32_MAX ||
+				keys < 0 || keys > UINT32_MAX) {
+				throw std::runtime_error(
+					"malformed camera path " + path + " at line " + std::to_string(lineNumber) + "!");
+			}
+			if (frames > 0) {
+				cameraPath.segments.push_back({ static_cast<uint32_t>(frames), static_cast<uint32_t>(keys) });
+				cameraPath.totalFrames += static_cast<uint64_t>(frames);
+			}
+		}
+		return cameraPath;
+	}
+
+	void CameraPath::save(const std::string& path) const
+	{
+		std::ofstream file{ path, std::ios::trunc };
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to open camera path " + path + "!");
+		}
+		file << "# <frames> <KeyboardMovementController::Key bits>\n";
+		for (const Segment& segment : segments) {
+			file << segment.frames << " " << segment.keys << "\n";
+		}
+		if (!file) {
+			throw std::runtime_error("failed to write camera path " + path + "!");
+		}
+	}
+
+	void CameraPath::record(uint32_t keys)
+	{
+		if (!segments.empty() && segments.back().keys == keys && segments.back().frames < UINT32_MAX) {
+			segments.back().frames++;
+		}
+		else {
+			segments.push_back({ 1, keys });
+		}
+		totalFrames++;
+	}
+
+	uint32_t CameraPath::keysAt(uint64_t frame) const
+	{
+		if (totalFrames == 0) {
+			return 0;
+		}
+		frame %= totalFrames;
+		for (const Segment& segment : segments) {
+			if (frame < segment.frames) {
+				return segment.keys;
+			}
+			frame -= segment.frames;
+		}
+		return 0;
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace VulkanEngine {
+	/* Per-frame input for KeyboardMovementController, as runs of held keys. Replayed at a fixed
+		timestep it moves the camera the same way on every run, which is what makes benchmarks
+		comparable. Files hold one "<frames> <keys>" run per line; # starts a comment. */
+	class CameraPath {
+	public:
+		struct Segment {
+			uint32_t frames;
+			uint32_t keys; // KeyboardMovementController::Key bits
+		};
+
+		// A built-in loop that moves, strafes, turns and looks up and down over the scene
+		static CameraPath scripted();
+		// Throws if the file can't be read or has a malformed line
+		static CameraPath load(const std::string& path);
+		void save(const std::string& path) const;
+
+		// Appends one frame of input, extending the last run when the keys are unchanged
+		void record(uint32_t keys);
+		// Keys held on the given frame; loops once the path runs out, 0 for an empty path
+		uint32_t keysAt(uint64_t frame) const;
+
+		bool empty() const { return totalFrames == 0; }
+		uint64_t frameCount() const { return totalFrames; }
+
+	private:
+		std::vector<Segment> segments;
+		uint64_t totalFrames = 0;
+	};
+}
@@ -0,0 +1,127 @@
+#include "EngineConfig.h"
+
+// std
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+namespace VulkanEngine {
+	namespace {
+		uint32_t parseCount(const std::string& flag, const char* value, uint32_t minimum, uint32_t maximum = UINT32_MAX) {
+			if (value == nullptr) {
+				throw std::runtime_error("missing value for " + flag + "!");
+			}
+			char* end = nullptr;
+			unsigned long count = std::strtoul(value, &end, 10);
+			if (end == value || *end != '\0' || count < minimum || count > maximum) {
+				throw std::runtime_error("invalid value for " + flag + ": " + value + "!");
+			}
+			return static_cast<uint32_t>(count);
+		}
+
+		VkPresentModeKHR parsePresentMode(const std::string& flag, const char* value) {
+			if (value == nullptr) {
+				throw std::runtime_error("missing value for " + flag + "!");
+			}
+			std::string mode = value;
+			if (mode == "fifo") return VK_PRESENT_MODE_FIFO_KHR;
+			if (mode == "fifo-relaxed") return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+			if (mode == "mailbox") return VK_PRESENT_MODE_MAILBOX_KHR;
+			if (mode == "immediate") return VK_PRESENT_MODE_IMMEDIATE_KHR;
+			throw std::runtime_error("invalid value for " + flag + ": " + mode + "!");
+		}
+
+		std::string parsePath(const std::string& flag, const char* value) {
+			if (value == nullptr) {
+				throw std::runtime_error("missing value for " + flag + "!");
+			}
+			return value;
+		}
+
+		double parseRate(const std::string& flag, const char* value) {
+			if (value == nullptr) {
+				throw std::runtime_error("missing value for " + flag + "!");
+			}
+			char* end = nullptr;
+			double rate = std::strtod(value, &end);
+			if (end == value || *end != '\0' || !(rate >= 0.0)) {
+				throw std::runtime_error("invalid value for " + flag + ": " + value + "!");
+			}
+			return rate;
+		}
+	}
+
+	EngineConfig EngineConfig::fromCommandLine(int argc, char** argv)
+	{
+		EngineConfig config{};
+		for (int i = 1; i < argc; i++) {
+			std::string flag = argv[i];
+			const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+			if (flag == "--frames-in-flight") {
+				config.framesInFlight = parseCount(flag, value, 1, MAX_FRAMES_IN_FLIGHT);
+				i++;
+			}
+			else if (flag == "--swapchain-images") {
+				config.minImageCount = parseCount(flag, value, 0);
+				i++;
+			}
+			else if (flag == "--present-mode") {
+				config.presentMode = parsePresentMode(flag, value);
+				i++;
+			}
+			else if (flag == "--max-fps") {
+				config.maxFps = parseRate(flag, value);
+				i++;
+			}
+			else if (flag == "--headless") {
+				config.headless = true;
+			}
+			else if (flag == "--frames") {
+				config.frameCount = parseCount(flag, value, 1);
+				i++;
+			}
+			else if (flag == "--trace") {
+				config.tracePath = parsePath(flag, value);
+				i++;
+			}
+			else if (flag == "--timestep") {
+				config.fixedTimestep = parseRate(flag, value);
+				i++;
+			}
+			else if (flag == "--benchmark") {
+				config.benchmark = true;
+			}
+			else if (flag == "--camera-path") {
+				config.cameraPath = parsePath(flag, value);
+				i++;
+			}
+			else if (flag == "--record-camera-path") {
+				config.recordCameraPath = parsePath(flag, value);
+				i++;
+			}
+			else if (flag == "--benchmark-report") {
+				config.benchmarkReport = parsePath(flag, value);
+				i++;
+			}
+			else if (flag == "--allocator-selftest") {
+				config.allocatorSelfTest = true;
+			}
+			else {
+				throw std::runtime_error("unknown option " + flag + "!");
+			}
+		}
+		if (config.benchmark) {
+			if (config.frameCount == 0) {
+				config.frameCount = DEFAULT_BENCHMARK_FRAMES;
+			}
+			if (config.fixedTimestep == 0.0) {
+				config.fixedTimestep = DEFAULT_BENCHMARK_TIMESTEP;
+			}
+		}
+		// nothing would ever close a headless run
+		if (config.headless && config.frameCount == 0) {
+			config.frameCount = DEFAULT_HEADLESS_FRAMES;
+		}
+		return config;
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+// libs
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <string>
+
+namespace VulkanEngine {
+	// Settings picked per deployment instead of at compile time; see fromCommandLine for the flags.
+	struct EngineConfig {
+		static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 4; // more only adds latency and per-frame memory
+		static constexpr uint32_t DEFAULT_HEADLESS_FRAMES = 1000;
+		static constexpr const char* DEFAULT_TRACE_PATH = "trace.json";
+		static constexpr uint32_t DEFAULT_BENCHMARK_FRAMES = 2000;
+		static constexpr double DEFAULT_BENCHMARK_TIMESTEP = 1.0 / 60.0;
+		static constexpr const char* DEFAULT_BENCHMARK_REPORT = "benchmark.json";
+
+		uint32_t framesInFlight = 2; // 1 for the lowest latency, 3 for throughput
+		uint32_t minImageCount = 0;  // swapchain images to ask for, 0 = one more than the surface minimum
+		VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+		double maxFps = 0.0;         // CPU frame cap, 0 = uncapped
+		bool headless = false;       // no window or surface: renders into offscreen images
+		uint32_t frameCount = 0;     // frames to render before exiting, 0 = until the window closes
+		std::string tracePath;       // traces the whole run into this file, empty = only on T key
+		double fixedTimestep = 0.0;  // simulated seconds per frame, 0 = measured wall time
+		bool benchmark = false;      // replays cameraPath at a fixed timestep and writes benchmarkReport on exit
+		std::string cameraPath;      // input replayed by a benchmark, empty = CameraPath::scripted
+		std::string recordCameraPath; // saves the live input here on exit, for later replay
+		std::string benchmarkReport = DEFAULT_BENCHMARK_REPORT;
+		bool allocatorSelfTest = false; // runs VulkanMemoryAllocator::runSelfTest instead of the app
+
+		/* --frames-in-flight N     (1 to MAX_FRAMES_IN_FLIGHT)
+			--swapchain-images N
+			--present-mode fifo|fifo-relaxed|mailbox|immediate
+			--max-fps N
+			--headless               (runs DEFAULT_HEADLESS_FRAMES frames unless --frames is given)
+			--frames N
+			--trace PATH             (Chrome trace JSON, written on exit)
+			--timestep SECONDS
+			--benchmark              (DEFAULT_BENCHMARK_FRAMES frames at DEFAULT_BENCHMARK_TIMESTEP unless given)
+			--camera-path PATH
+			--record-camera-path PATH
+			--benchmark-report PATH
+			--allocator-selftest     (CPU only, no window or device)
+			Unknown flags and malformed values throw. */
+		static EngineConfig fromCommandLine(int argc, char** argv);
+	};
+}
@@ -0,0 +1,78 @@
+#include "FrameLimiter.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <timeapi.h>
+#endif
+
+// std
+#include <algorithm>
+#include <thread>
+
+namespace VulkanEngine {
+	FrameLimiter::FrameLimiter(double maxFps, std::chrono::microseconds spinMargin)
+		: spinMargin{ spinMargin }
+	{
+		setMaxFps(maxFps);
+	}
+
+	FrameLimiter::~FrameLimiter()
+	{
+		setTimerResolutionRaised(false);
+	}
+
+	void FrameLimiter::setMaxFps(double fps)
+	{
+		maxFps = fps > 0.0 ? fps : 0.0;
+		period = maxFps > 0.0
+			? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / maxFps))
+			: Clock::duration::zero();
+		deadline = Clock::time_point{};
+		sleepOvershoot = Clock::duration::zero();
+		// a finer timer costs power system-wide, so only while something is being paced
+		setTimerResolutionRaised(maxFps > 0.0);
+	}
+
+	void FrameLimiter::setTimerResolutionRaised(bool raised)
+	{
+		if (raised == timerResolutionRaised) {
+			return;
+		}
+#ifdef _WIN32
+		if (raised) {
+			raised = timeBeginPeriod(1) == TIMERR_NOERROR;
+		}
+		else {
+			timeEndPeriod(1);
+		}
+#endif
+		timerResolutionRaised = raised;
+	}
+
+	void FrameLimiter::wait()
+	{
+		if (period == Clock::duration::zero()) {
+			return;
+		}
+
+		auto now = Clock::now();
+		if (deadline == Clock::time_point{} || now - deadline > period) {
+			// first frame, or too far behind to catch up
+			deadline = now + period;
+			return;
+		}
+
+		auto sleepTime = deadline - now - spinMargin - sleepOvershoot;
+		if (sleepTime > Clock::duration::zero()) {
+			std::this_thread::sleep_for(sleepTime);
+			auto overshoot = Clock::now() - now - sleepTime;
+			sleepOvershoot = std::max(overshoot, sleepOvershoot - sleepOvershoot / 16);
+		}
+		while (Clock::now() < deadline) {
+			std::this_thread::yield();
+		}
+		deadline += period;
+	}
+}
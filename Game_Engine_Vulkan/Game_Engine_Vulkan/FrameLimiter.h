@@ -0,0 +1,42 @@
+#pragma once
+
+// std
+#include <chrono>
+
+namespace VulkanEngine {
+	/* Caps the frame rate on the CPU, independent of the present mode. OS sleeps can overshoot by a
+		scheduler tick, so wait() sleeps until shortly before the deadline and spins the rest of
+		the way. While a cap is set the system timer runs at 1 ms on Windows (its default tick is
+		15.6 ms), and the measured sleep overshoot widens the spin margin wherever that isn't enough.
+		Deadlines advance by a fixed period rather than from "now", so the pace doesn't drift; a
+		frame that runs more than a whole period late resets it instead of bursting. */
+	class FrameLimiter {
+	public:
+		using Clock = std::chrono::steady_clock;
+		// how far ahead of the deadline sleeping gives way to spinning, before measured overshoot
+		static constexpr std::chrono::microseconds DEFAULT_SPIN_MARGIN{ 2000 };
+
+		// maxFps 0 = uncapped
+		explicit FrameLimiter(double maxFps = 0.0, std::chrono::microseconds spinMargin = DEFAULT_SPIN_MARGIN);
+		~FrameLimiter();
+
+		FrameLimiter(const FrameLimiter&) = delete;
+		FrameLimiter& operator=(const FrameLimiter&) = delete;
+
+		void setMaxFps(double maxFps);
+		double getMaxFps() const { return maxFps; }
+
+		// Call once per frame; returns when the next frame may start
+		void wait();
+
+	private:
+		void setTimerResolutionRaised(bool raised);
+
+		double maxFps = 0.0;
+		Clock::duration period{};
+		Clock::duration spinMargin;
+		Clock::duration sleepOvershoot{}; // worst recent oversleep, slowly forgotten
+		Clock::time_point deadline{};
+		bool timerResolutionRaised = false;
+	};
+}
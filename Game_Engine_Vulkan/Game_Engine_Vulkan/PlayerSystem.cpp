@@ -16,17 +16,13 @@ namespace VulkanEngine {
 		glm::mat4 normalMatrix{ 1.f };
 	};
 
-	PlayerSystem::PlayerSystem(VulkanDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout)
-		: vulkanDevice{ device }
+	PlayerSystem::PlayerSystem(VulkanDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout,
+		VulkanPipelineQueue& pipelineQueue)
+		: VulkanRenderSystem{ device }
 	{
 		createPipelineLayout(globalSetLayout);
-		createPipeline(renderPass);
+		createPipeline(renderPass, pipelineQueue);
 	}
-	PlayerSystem::~PlayerSystem()
-	{
-		vkDestroyPipelineLayout(vulkanDevice.device(), pipelineLayout, nullptr);
-	}
-
 	void PlayerSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
 	{
 		VkPushConstantRange pushConstantRange{};
@@ -47,22 +43,21 @@ namespace VulkanEngine {
 			throw std::runtime_error("failed to create pipeline layout!");
 		}
 	}
-	void PlayerSystem::createPipeline(VkRenderPass renderPass)
+	void PlayerSystem::createPipeline(VkRenderPass renderPass, VulkanPipelineQueue& pipelineQueue)
 	{
 		assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
-		PipelineConfigInfo pipelineConfig{};
-		VulkanPipeline::defaultPipelineConfigInfo(pipelineConfig);
-		pipelineConfig.renderPass = renderPass;
-		pipelineConfig.pipelineLayout = pipelineLayout;
+		auto pipelineConfig = std::make_unique<PipelineConfigInfo>();
+		VulkanPipeline::defaultPipelineConfigInfo(*pipelineConfig);
+		pipelineConfig->renderPass = renderPass;
+		pipelineConfig->pipelineLayout = pipelineLayout;
 
-		//pipelineConfig.rasterizationInfo.polygonMode = VK_POLYGON_MODE_LINE;
+		//pipelineConfig->rasterizationInfo.polygonMode = VK_POLYGON_MODE_LINE;
 
-		vulkanPipeline = std::make_unique<VulkanPipeline>(
-			vulkanDevice,
+		vulkanPipeline = pipelineQueue.submit(
 			"shaders/simple_shader.vert.spv",
 			"shaders/simple_shader.frag.spv",
-			pipelineConfig);
+			std::move(pipelineConfig));
 	}
 
 	void PlayerSystem::update(FrameInfo& frameInfo)
@@ -75,17 +70,18 @@ namespace VulkanEngine {
 	}
 
 	void PlayerSystem::render(FrameInfo& frameInfo) {
-		vulkanPipeline->bind(frameInfo.commandBuffer);
+		vulkanPipeline->bind(frameInfo.commandBuffer, frameInfo.commandStats);
 
-		vkCmdBindDescriptorSets(
+		VulkanCommands::bindDescriptorSets(
+			frameInfo.commandStats,
 			frameInfo.commandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
 			pipelineLayout,
 			0,
 			1,
 			&frameInfo.globalDescriptorSet,
-			0,
-			nullptr
+			1,
+			&frameInfo.globalUboOffset
 		);
 
 		auto& obj = frameInfo.gamePlayer;
@@ -96,7 +92,8 @@ namespace VulkanEngine {
 		/*std::cout << "transform.translation.x: " << obj.transform.translation.x << "\n";
 		std::cout << "transform.translation.y: " << obj.transform.translation.y << "\n";
 		std::cout << "transform.translation.z: " << obj.transform.translation.z << "\n";*/
-		vkCmdPushConstants(
+		VulkanCommands::pushConstants(
+			frameInfo.commandStats,
 			frameInfo.commandBuffer,
 			pipelineLayout,
 			VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
@@ -104,7 +101,6 @@ namespace VulkanEngine {
 			sizeof(SimplePushConstantData),
 			&push
 		);
-		obj.model->bind(frameInfo.commandBuffer);
-		obj.model->draw(frameInfo.commandBuffer);
+		obj.model->draw(frameInfo.commandBuffer, frameInfo.commandStats);
 	}
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include "VulkanCamera.h"
 #include "VulkanPipeline.h"
+#include "VulkanPipelineQueue.h"
+#include "VulkanRenderSystem.h"
 #include "VulkanDevice.h"
 #include "VulkanGameObject.h"
 #include "VulkanFrameInfo.h"
@@ -10,15 +12,15 @@
 #include <memory>
 #include <vector>
 namespace VulkanEngine {
-	class PlayerSystem {
+	class PlayerSystem : public VulkanRenderSystem {
 	public:
 
 		PlayerSystem(
 			VulkanDevice& device,
 			VkRenderPass renderPass,
-			VkDescriptorSetLayout globalSetLayout
+			VkDescriptorSetLayout globalSetLayout,
+			VulkanPipelineQueue& pipelineQueue
 		);
-		~PlayerSystem();
 
 		PlayerSystem(const PlayerSystem&) = delete; // deleting copy constructors
 		PlayerSystem& operator=(const PlayerSystem&) = delete;
@@ -28,11 +30,6 @@ namespace VulkanEngine {
 
 	private:
 		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-		void createPipeline(VkRenderPass renderPass);
-
-		VulkanDevice& vulkanDevice;
-
-		std::unique_ptr<VulkanPipeline> vulkanPipeline;
-		VkPipelineLayout pipelineLayout;
+		void createPipeline(VkRenderPass renderPass, VulkanPipelineQueue& pipelineQueue);
 	};
 }
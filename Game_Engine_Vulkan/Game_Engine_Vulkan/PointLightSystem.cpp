@@ -18,17 +18,13 @@ namespace VulkanEngine {
 		float radius;
 	};
 
-	PointLightSystem::PointLightSystem(VulkanDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout)
-		: vulkanDevice{ device }
+	PointLightSystem::PointLightSystem(VulkanDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout,
+		VulkanPipelineQueue& pipelineQueue)
+		: VulkanRenderSystem{ device }
 	{
 		createPipelineLayout(globalSetLayout);
-		createPipeline(renderPass);
+		createPipeline(renderPass, pipelineQueue);
 	}
-	PointLightSystem::~PointLightSystem()
-	{
-		vkDestroyPipelineLayout(vulkanDevice.device(), pipelineLayout, nullptr);
-	}
-
 	void PointLightSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
 	{
 		VkPushConstantRange pushConstantRange{};
@@ -49,22 +45,21 @@ namespace VulkanEngine {
 			throw std::runtime_error("failed to create pipeline layout!");
 		}
 	}
-	void PointLightSystem::createPipeline(VkRenderPass renderPass)
+	void PointLightSystem::createPipeline(VkRenderPass renderPass, VulkanPipelineQueue& pipelineQueue)
 	{
 		assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
-		PipelineConfigInfo pipelineConfig{};
-		VulkanPipeline::defaultPipelineConfigInfo(pipelineConfig);
+		auto pipelineConfig = std::make_unique<PipelineConfigInfo>();
+		VulkanPipeline::defaultPipelineConfigInfo(*pipelineConfig);
 
-		pipelineConfig.attributeDescriptions.clear();
-		pipelineConfig.bindingDescriptions.clear();
-		pipelineConfig.renderPass = renderPass;
-		pipelineConfig.pipelineLayout = pipelineLayout;
-		vulkanPipeline = std::make_unique<VulkanPipeline>(
-			vulkanDevice,
+		pipelineConfig->attributeDescriptions.clear();
+		pipelineConfig->bindingDescriptions.clear();
+		pipelineConfig->renderPass = renderPass;
+		pipelineConfig->pipelineLayout = pipelineLayout;
+		vulkanPipeline = pipelineQueue.submit(
 			"shaders/point_light.vert.spv",
 			"shaders/point_light.frag.spv",
-			pipelineConfig);
+			std::move(pipelineConfig));
 	}
 
 	void PointLightSystem::update(FrameInfo& frameInfo, GlobalUbo& ubo) {
@@ -89,17 +84,18 @@ namespace VulkanEngine {
 	}
 
 	void PointLightSystem::render(FrameInfo& frameInfo) {
-		vulkanPipeline->bind(frameInfo.commandBuffer);
+		vulkanPipeline->bind(frameInfo.commandBuffer, frameInfo.commandStats);
 
-		vkCmdBindDescriptorSets(
+		VulkanCommands::bindDescriptorSets(
+			frameInfo.commandStats,
 			frameInfo.commandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
 			pipelineLayout,
 			0,
 			1,
 			&frameInfo.globalDescriptorSet,
-			0,
-			nullptr
+			1,
+			&frameInfo.globalUboOffset
 		);
 		for (auto& kv : frameInfo.gameLightObjects) {
 			auto& obj = kv.second;
@@ -110,14 +106,15 @@ namespace VulkanEngine {
 			push.color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
 			push.radius = obj.transform.scale.x;
 
-			vkCmdPushConstants(
+			VulkanCommands::pushConstants(
+				frameInfo.commandStats,
 				frameInfo.commandBuffer,
 				pipelineLayout,
 				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
 				0,
 				sizeof(PointLightPushConstants),
 				&push);
-			vkCmdDraw(frameInfo.commandBuffer, 6, 1, 0, 0);
+			VulkanCommands::draw(frameInfo.commandStats, frameInfo.commandBuffer, 6, 1, 0, 0);
 		}
 	}
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include "VulkanCamera.h"
 #include "VulkanPipeline.h"
+#include "VulkanPipelineQueue.h"
+#include "VulkanRenderSystem.h"
 #include "VulkanDevice.h"
 #include "VulkanGameObject.h"
 #include "VulkanFrameInfo.h"
@@ -10,15 +12,15 @@
 #include <memory>
 #include <vector>
 namespace VulkanEngine {
-	class PointLightSystem {
+	class PointLightSystem : public VulkanRenderSystem {
 	public:
 
 		PointLightSystem(
 			VulkanDevice& device,
 			VkRenderPass renderPass,
-			VkDescriptorSetLayout globalSetLayout
+			VkDescriptorSetLayout globalSetLayout,
+			VulkanPipelineQueue& pipelineQueue
 		);
-		~PointLightSystem();
 
 		PointLightSystem(const PointLightSystem&) = delete; // deleting copy constructors
 		PointLightSystem& operator=(const PointLightSystem&) = delete;
@@ -29,11 +31,6 @@ namespace VulkanEngine {
 	private:
 		// Simple Render System - Anything that acts upon a subset of a game object components is a system
 		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-		void createPipeline(VkRenderPass renderPass);
-
-		VulkanDevice& vulkanDevice;
-
-		std::unique_ptr<VulkanPipeline> vulkanPipeline;
-		VkPipelineLayout pipelineLayout;
+		void createPipeline(VkRenderPass renderPass, VulkanPipelineQueue& pipelineQueue);
 	};
 }
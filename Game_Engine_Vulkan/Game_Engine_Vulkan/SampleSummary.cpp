@@ -0,0 +1,32 @@
+#include "SampleSummary.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+
+namespace VulkanEngine {
+	// nearest rank on sorted samples
+	static double percentile(const std::vector<double>& sorted, double fraction) {
+		size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+		return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+	}
+
+	SampleSummary SampleSummary::of(std::vector<double> samples)
+	{
+		SampleSummary summary{};
+		if (samples.empty()) {
+			return summary;
+		}
+		std::sort(samples.begin(), samples.end());
+		summary.count = samples.size();
+		for (double sample : samples) {
+			summary.mean += sample;
+		}
+		summary.mean /= samples.size();
+		summary.p50 = percentile(samples, 0.50);
+		summary.p95 = percentile(samples, 0.95);
+		summary.p99 = percentile(samples, 0.99);
+		summary.max = samples.back();
+		return summary;
+	}
+}
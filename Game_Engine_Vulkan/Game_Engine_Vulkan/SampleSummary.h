@@ -0,0 +1,20 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <vector>
+
+namespace VulkanEngine {
+	// Mean, nearest-rank percentiles and maximum of a set of timings
+	struct SampleSummary {
+		size_t count = 0;
+		double mean = 0.0;
+		double p50 = 0.0;
+		double p95 = 0.0;
+		double p99 = 0.0;
+		double max = 0.0;
+
+		// All zero for no samples
+		static SampleSummary of(std::vector<double> samples);
+	};
+}
@@ -14,17 +14,13 @@ namespace VulkanEngine {
 		glm::mat4 normalMatrix{ 1.f };
 	};
 
-	SimpleRenderSystem::SimpleRenderSystem(VulkanDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout)
-		: vulkanDevice{ device }
+	SimpleRenderSystem::SimpleRenderSystem(VulkanDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout,
+		VulkanPipelineQueue& pipelineQueue)
+		: VulkanRenderSystem{ device }
 	{
 		createPipelineLayout(globalSetLayout);
-		createPipeline(renderPass);
+		createPipeline(renderPass, pipelineQueue);
 	}
-	SimpleRenderSystem::~SimpleRenderSystem()
-	{
-		vkDestroyPipelineLayout(vulkanDevice.device(), pipelineLayout, nullptr);
-	}
-
 	void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
 	{
 		VkPushConstantRange pushConstantRange{};
@@ -45,60 +41,82 @@ namespace VulkanEngine {
 			throw std::runtime_error("failed to create pipeline layout!");
 		}
 	}
-	void SimpleRenderSystem::createPipeline(VkRenderPass renderPass)
+	void SimpleRenderSystem::createPipeline(VkRenderPass renderPass, VulkanPipelineQueue& pipelineQueue)
 	{
 		assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
-		PipelineConfigInfo pipelineConfig{};
-		VulkanPipeline::defaultPipelineConfigInfo(pipelineConfig);
-		VulkanPipeline::enableAlphaBlending(pipelineConfig);
+		auto pipelineConfig = std::make_unique<PipelineConfigInfo>();
+		VulkanPipeline::defaultPipelineConfigInfo(*pipelineConfig);
+		VulkanPipeline::enableAlphaBlending(*pipelineConfig);
 
-		pipelineConfig.renderPass = renderPass;
-		pipelineConfig.pipelineLayout = pipelineLayout;
+		pipelineConfig->renderPass = renderPass;
+		pipelineConfig->pipelineLayout = pipelineLayout;
 
-		//pipelineConfig.rasterizationInfo.polygonMode = VK_POLYGON_MODE_LINE;
-		pipelineConfig.rasterizationInfo.polygonMode = VK_POLYGON_MODE_FILL;
+		//pipelineConfig->rasterizationInfo.polygonMode = VK_POLYGON_MODE_LINE;
+		pipelineConfig->rasterizationInfo.polygonMode = VK_POLYGON_MODE_FILL;
 
-		vulkanPipeline = std::make_unique<VulkanPipeline>(
-			vulkanDevice,
+		vulkanPipeline = pipelineQueue.submit(
 			"shaders/simple_shader.vert.spv",
 			"shaders/simple_shader.frag.spv",
-			pipelineConfig);
+			std::move(pipelineConfig));
 	}
 
 	void SimpleRenderSystem::renderGameObjects(FrameInfo& frameInfo) {
-		vulkanPipeline->bind(frameInfo.commandBuffer);
+		bindPipeline(frameInfo);
+		for (auto& kv : frameInfo.gameMeshObjects) {
+			//if (kv.second.model == nullptr) continue;
+			renderGameObject(frameInfo, kv.second);
+		}
+	}
+
+	void SimpleRenderSystem::renderGameObjects(FrameInfo& frameInfo, VulkanGameObject* const* objects, size_t count) {
+		bindPipeline(frameInfo);
+		for (size_t i = 0; i < count; i++) {
+			renderGameObject(frameInfo, *objects[i]);
+		}
+	}
+
+	void SimpleRenderSystem::addRecordingKey(
+		RecordingKey& key, const FrameInfo& frameInfo, VulkanGameObject* const* objects, size_t count) const {
+		key.add(vulkanPipeline->getPipeline(), pipelineLayout, frameInfo.globalDescriptorSet,
+			frameInfo.globalUboOffset, count);
+		for (size_t i = 0; i < count; i++) {
+			VulkanGameObject& obj = *objects[i];
+			key.add(obj.getId(), obj.model.get(),
+				obj.transform.translation, obj.transform.rotation, obj.transform.scale);
+		}
+	}
 
-		vkCmdBindDescriptorSets(
+	void SimpleRenderSystem::bindPipeline(FrameInfo& frameInfo) {
+		vulkanPipeline->bind(frameInfo.commandBuffer, frameInfo.commandStats);
+
+		VulkanCommands::bindDescriptorSets(
+			frameInfo.commandStats,
 			frameInfo.commandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
 			pipelineLayout,
 			0,
 			1,
 			&frameInfo.globalDescriptorSet,
-			0,
-			nullptr
+			1,
+			&frameInfo.globalUboOffset
 		);
+	}
 
-		for (auto& kv : frameInfo.gameMeshObjects) {
-			auto& obj = kv.second;
-			//if (obj.model == nullptr) continue;
-
-			SimplePushConstantData push{};
-			push.modelMatrix = obj.transform.mat4();
-			push.normalMatrix = obj.transform.normalMatrix();
-			
-
-			vkCmdPushConstants(
-				frameInfo.commandBuffer, 
-				pipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-				0,
-				sizeof(SimplePushConstantData),
-				&push
-			);
-			obj.model->bind(frameInfo.commandBuffer);
-			obj.model->draw(frameInfo.commandBuffer);
-		}
+	void SimpleRenderSystem::renderGameObject(FrameInfo& frameInfo, VulkanGameObject& obj) {
+		SimplePushConstantData push{};
+		push.modelMatrix = obj.transform.mat4();
+		push.normalMatrix = obj.transform.normalMatrix();
+
+		VulkanCommands::pushConstants(
+			frameInfo.commandStats,
+			frameInfo.commandBuffer,
+			pipelineLayout,
+			VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+			0,
+			sizeof(SimplePushConstantData),
+			&push
+		);
+		obj.model->draw(frameInfo.commandBuffer, frameInfo.commandStats);
 	}
 }
\ No newline at end of file
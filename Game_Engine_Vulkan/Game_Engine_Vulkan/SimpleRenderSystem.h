@@ -2,37 +2,42 @@
 
 #include "VulkanCamera.h"
 #include "VulkanPipeline.h"
+#include "VulkanPipelineQueue.h"
+#include "VulkanRenderSystem.h"
 #include "VulkanDevice.h"
 #include "VulkanGameObject.h"
 #include "VulkanFrameInfo.h"
+#include "VulkanUtility.h"
 
 // std
 #include <memory>
 #include <vector>
 namespace VulkanEngine {
-	class SimpleRenderSystem {
+	class SimpleRenderSystem : public VulkanRenderSystem {
 	public:
 
 		SimpleRenderSystem(
 			VulkanDevice& device, 
 			VkRenderPass renderPass, 
-			VkDescriptorSetLayout globalSetLayout
+			VkDescriptorSetLayout globalSetLayout,
+			VulkanPipelineQueue& pipelineQueue
 		);
-		~SimpleRenderSystem();
 
 		SimpleRenderSystem(const SimpleRenderSystem&) = delete; // deleting copy constructors
 		SimpleRenderSystem& operator=(const SimpleRenderSystem&) = delete;
 
 		void renderGameObjects(FrameInfo& frameInfo);
+		// Draws only objects[0..count), so chunks of the scene can be recorded on different threads
+		void renderGameObjects(FrameInfo& frameInfo, VulkanGameObject* const* objects, size_t count);
+		// Adds everything the call above bakes into a command buffer to key, to tell when a cached recording is stale
+		void addRecordingKey(
+			RecordingKey& key, const FrameInfo& frameInfo, VulkanGameObject* const* objects, size_t count) const;
 
 	private:
 		// Simple Render System - Anything that acts upon a subset of a game object components is a system
 		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-		void createPipeline(VkRenderPass renderPass);
-
-		VulkanDevice& vulkanDevice;
-
-		std::unique_ptr<VulkanPipeline> vulkanPipeline;
-		VkPipelineLayout pipelineLayout;
+		void createPipeline(VkRenderPass renderPass, VulkanPipelineQueue& pipelineQueue);
+		void bindPipeline(FrameInfo& frameInfo);
+		void renderGameObject(FrameInfo& frameInfo, VulkanGameObject& obj);
 	};
 }
@@ -0,0 +1,185 @@
+#include "Tracer.h"
+
+// std
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace VulkanEngine {
+	std::atomic<bool> Tracer::enabled{ false };
+
+	namespace {
+		struct Zone {
+			const char* name;
+			const char* category;
+			int64_t startNs;
+			int64_t durationNs;
+		};
+
+		// Written only by its thread; count is published with release so the writer can read up to it
+		struct ThreadBuffer {
+			uint32_t trackId = 0;
+			std::string name;
+			std::vector<Zone> zones;
+			std::atomic<size_t> count{ 0 };
+			std::atomic<size_t> dropped{ 0 };
+		};
+
+		struct Registry {
+			std::mutex mutex; // only taken when a thread records for the first time and around a capture
+			std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+			int64_t captureStartNs = 0;
+		};
+
+		Registry& registry() {
+			static Registry instance;
+			return instance;
+		}
+
+		ThreadBuffer* createBuffer(const std::string& name) {
+			auto buffer = std::make_unique<ThreadBuffer>();
+			buffer->zones.resize(Tracer::DEFAULT_ZONES_PER_THREAD);
+
+			Registry& reg = registry();
+			std::lock_guard<std::mutex> lock{ reg.mutex };
+			buffer->trackId = static_cast<uint32_t>(reg.buffers.size());
+			buffer->name = name.empty() ? "Thread " + std::to_string(buffer->trackId) : name;
+			reg.buffers.push_back(std::move(buffer));
+			return reg.buffers.back().get();
+		}
+
+		// the buffer is only allocated once the thread records, so idle threads cost nothing
+		thread_local ThreadBuffer* threadBuffer = nullptr;
+		thread_local std::string threadName;
+
+		ThreadBuffer& currentThreadBuffer() {
+			if (threadBuffer == nullptr) {
+				threadBuffer = createBuffer(threadName);
+			}
+			return *threadBuffer;
+		}
+
+		// fed from whichever thread collects the GPU timestamps
+		ThreadBuffer& gpuBuffer() {
+			static ThreadBuffer* buffer = createBuffer("GPU");
+			return *buffer;
+		}
+
+		void append(ThreadBuffer& buffer, const Zone& zone) {
+			size_t index = buffer.count.load(std::memory_order_relaxed);
+			if (index >= buffer.zones.size()) {
+				buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			buffer.zones[index] = zone;
+			buffer.count.store(index + 1, std::memory_order_release);
+		}
+
+		void writeEscaped(std::ostream& out, const std::string& text) {
+			out << '"';
+			for (char c : text) {
+				if (c == '"' || c == '\\') {
+					out << '\\' << c;
+				}
+				else if (static_cast<unsigned char>(c) < 0x20) {
+					out << ' ';
+				}
+				else {
+					out << c;
+				}
+			}
+			out << '"';
+		}
+	}
+
+	void Tracer::start()
+	{
+		gpuBuffer();
+		Registry& reg = registry();
+		{
+			std::lock_guard<std::mutex> lock{ reg.mutex };
+			for (auto& buffer : reg.buffers) {
+				buffer->count.store(0, std::memory_order_relaxed);
+				buffer->dropped.store(0, std::memory_order_relaxed);
+			}
+			reg.captureStartNs = now();
+		}
+		enabled.store(true, std::memory_order_release);
+	}
+
+	void Tracer::stop()
+	{
+		enabled.store(false, std::memory_order_release);
+	}
+
+	int64_t Tracer::now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void Tracer::record(const char* name, const char* category, int64_t startNs, int64_t durationNs)
+	{
+		append(currentThreadBuffer(), Zone{ name, category, startNs, durationNs });
+	}
+
+	void Tracer::recordGpu(const char* name, int64_t startNs, int64_t durationNs)
+	{
+		append(gpuBuffer(), Zone{ name, "gpu", startNs, durationNs });
+	}
+
+	void Tracer::setThreadName(const std::string& name)
+	{
+		threadName = name;
+		if (threadBuffer == nullptr) {
+			return;
+		}
+		std::lock_guard<std::mutex> lock{ registry().mutex };
+		threadBuffer->name = name;
+	}
+
+	void Tracer::writeChromeTrace(const std::string& path)
+	{
+		std::ofstream out{ path, std::ios::trunc };
+		if (!out) {
+			throw std::runtime_error("failed to open trace file " + path + "!");
+		}
+
+		Registry& reg = registry();
+		std::lock_guard<std::mutex> lock{ reg.mutex };
+		// Chrome traces are in microseconds; relative to the capture start they stay readable
+		out << std::fixed << std::setprecision(3);
+		out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		bool first = true;
+		size_t dropped = 0;
+		for (auto& buffer : reg.buffers) {
+			out << (first ? "\n" : ",\n");
+			first = false;
+			out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->trackId << ",\"args\":{\"name\":";
+			writeEscaped(out, buffer->name);
+			out << "}}";
+
+			size_t count = buffer->count.load(std::memory_order_acquire);
+			for (size_t i = 0; i < count; i++) {
+				const Zone& zone = buffer->zones[i];
+				out << ",\n{\"name\":";
+				writeEscaped(out, zone.name);
+				out << ",\"cat\":";
+				writeEscaped(out, zone.category);
+				out << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->trackId
+					<< ",\"ts\":" << (zone.startNs - reg.captureStartNs) / 1000.0
+					<< ",\"dur\":" << zone.durationNs / 1000.0 << "}";
+			}
+			dropped += buffer->dropped.load(std::memory_order_relaxed);
+		}
+		out << "\n],\"otherData\":{\"droppedZones\":" << dropped << "}}\n";
+
+		if (!out) {
+			throw std::runtime_error("failed to write trace file " + path + "!");
+		}
+	}
+}
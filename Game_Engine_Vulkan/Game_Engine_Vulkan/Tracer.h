@@ -0,0 +1,63 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace VulkanEngine {
+	/* Records timed zones into per-thread buffers and writes them out as a Chrome trace, which
+		chrome://tracing and ui.perfetto.dev open. Each thread appends to its own fixed-size buffer
+		without locking; a full buffer drops zones instead of growing. While disabled a zone costs a
+		single relaxed atomic load.
+		start, stop and writeChromeTrace must not overlap recording on other threads: call them
+		between frames, when no worker task is running. */
+	class Tracer {
+	public:
+		static constexpr size_t DEFAULT_ZONES_PER_THREAD = 1 << 16;
+
+		static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+		// Drops whatever the previous capture recorded
+		static void start();
+		static void stop();
+
+		// Nanoseconds on the clock every zone is measured with
+		static int64_t now();
+		// name and category must outlive the capture, string literals in practice
+		static void record(const char* name, const char* category, int64_t startNs, int64_t durationNs);
+		// GPU zones go on their own track; the times must already be converted to the CPU clock
+		static void recordGpu(const char* name, int64_t startNs, int64_t durationNs);
+		// Label for the calling thread's track
+		static void setThreadName(const std::string& name);
+
+		// Throws if the file can't be written
+		static void writeChromeTrace(const std::string& path);
+
+	private:
+		static std::atomic<bool> enabled;
+	};
+
+	// Times its own lifetime as one zone on the calling thread's track
+	class TraceZone {
+	public:
+		explicit TraceZone(const char* name, const char* category = "cpu")
+			: name{ name }, category{ category }, startNs{ Tracer::isEnabled() ? Tracer::now() : -1 } {}
+		~TraceZone() { end(); }
+
+		// Closes the zone before the end of its scope; later calls do nothing
+		void end() {
+			if (startNs >= 0) {
+				Tracer::record(name, category, startNs, Tracer::now() - startNs);
+				startNs = -1;
+			}
+		}
+
+		TraceZone(const TraceZone&) = delete;
+		TraceZone& operator=(const TraceZone&) = delete;
+
+	private:
+		const char* name;
+		const char* category;
+		int64_t startNs;
+	};
+}
@@ -8,6 +8,7 @@
 #include "VulkanBuffer.h"
 
  // std
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 
@@ -43,13 +44,30 @@ namespace VulkanEngine {
         memoryPropertyFlags{ memoryPropertyFlags } {
         alignmentSize = getAlignment(instanceSize, minOffsetAlignment);
         bufferSize = alignmentSize * instanceCount;
-        device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory);
+        device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, allocation);
+        this->memoryPropertyFlags = device.allocator().getMemoryTypeProperties(allocation.memoryTypeIndex);
+    }
+
+    VulkanBuffer::VulkanBuffer(
+        VulkanDevice& device,
+        VkDeviceSize instanceSize,
+        uint32_t instanceCount,
+        VkBufferUsageFlags usageFlags,
+        VulkanMemoryUsage memoryUsage,
+        VkDeviceSize minOffsetAlignment)
+        : vulkanDevice{ device },
+        instanceCount{ instanceCount },
+        instanceSize{ instanceSize },
+        usageFlags{ usageFlags } {
+        alignmentSize = getAlignment(instanceSize, minOffsetAlignment);
+        bufferSize = alignmentSize * instanceCount;
+        device.createBuffer(bufferSize, usageFlags, memoryUsage, buffer, allocation);
+        memoryPropertyFlags = device.allocator().getMemoryTypeProperties(allocation.memoryTypeIndex);
     }
 
     VulkanBuffer::~VulkanBuffer() {
         unmap();
-        vkDestroyBuffer(vulkanDevice.device(), buffer, nullptr);
-        vkFreeMemory(vulkanDevice.device(), memory, nullptr);
+        vulkanDevice.destroyBuffer(buffer, allocation);
     }
 
     /**
@@ -62,23 +80,22 @@ namespace VulkanEngine {
      * @return VkResult of the buffer mapping call
      */
     VkResult VulkanBuffer::map(VkDeviceSize size, VkDeviceSize offset) {
-        assert(buffer && memory && "Called map on buffer before create");
-        if (size == VK_WHOLE_SIZE) {
-            return vkMapMemory(vulkanDevice.device(), memory, 0, bufferSize, 0, &mapped);
+        assert(buffer && allocation.memory && "Called map on buffer before create");
+        // host-visible memory blocks are persistently mapped by the allocator
+        if (allocation.mapped == nullptr) {
+            return VK_ERROR_MEMORY_MAP_FAILED;
         }
-        return vkMapMemory(vulkanDevice.device(), memory, offset, size, 0, &mapped);
+        mapped = static_cast<char*>(allocation.mapped) + offset;
+        return VK_SUCCESS;
     }
 
     /**
      * Unmap a mapped memory range
      *
-     * @note Does not return a result as vkUnmapMemory can't fail
+     * @note The underlying memory block stays mapped; this only drops the buffer's pointer into it
      */
     void VulkanBuffer::unmap() {
-        if (mapped) {
-            vkUnmapMemory(vulkanDevice.device(), memory);
-            mapped = nullptr;
-        }
+        mapped = nullptr;
     }
 
     /**
@@ -106,7 +123,7 @@ namespace VulkanEngine {
     /**
      * Flush a memory range of the buffer to make it visible to the device
      *
-     * @note Only required for non-coherent memory
+     * @note Only required for non-coherent memory; returns VK_SUCCESS straight away otherwise
      *
      * @param size (Optional) Size of the memory range to flush. Pass VK_WHOLE_SIZE to flush the
      * complete buffer range.
@@ -115,18 +132,17 @@ namespace VulkanEngine {
      * @return VkResult of the flush call
      */
     VkResult VulkanBuffer::flush(VkDeviceSize size, VkDeviceSize offset) {
-        VkMappedMemoryRange mappedRange = {};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
+        if (memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) {
+            return VK_SUCCESS;
+        }
+        VkMappedMemoryRange mappedRange = getMappedRange(size, offset);
         return vkFlushMappedMemoryRanges(vulkanDevice.device(), 1, &mappedRange);
     }
 
     /**
      * Invalidate a memory range of the buffer to make it visible to the host
      *
-     * @note Only required for non-coherent memory
+     * @note Only required for non-coherent memory; returns VK_SUCCESS straight away otherwise
      *
      * @param size (Optional) Size of the memory range to invalidate. Pass VK_WHOLE_SIZE to invalidate
      * the complete buffer range.
@@ -135,12 +151,40 @@ namespace VulkanEngine {
      * @return VkResult of the invalidate call
      */
     VkResult VulkanBuffer::invalidate(VkDeviceSize size, VkDeviceSize offset) {
+        if (memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) {
+            return VK_SUCCESS;
+        }
+        VkMappedMemoryRange mappedRange = getMappedRange(size, offset);
+        return vkInvalidateMappedMemoryRanges(vulkanDevice.device(), 1, &mappedRange);
+    }
+
+    /**
+     * Translates a range of this buffer into a range of its shared memory block
+     *
+     * @note The range is widened to nonCoherentAtomSize; the allocator pads non-coherent
+     * allocations to that size, so the widened range never leaves this buffer's allocation
+     *
+     * @param size Size of the range. VK_WHOLE_SIZE covers the rest of the buffer
+     * @param offset Byte offset from beginning of the buffer
+     *
+     * @return VkMappedMemoryRange for flush/invalidate calls
+     */
+    VkMappedMemoryRange VulkanBuffer::getMappedRange(VkDeviceSize size, VkDeviceSize offset) {
+        VkDeviceSize atomSize = vulkanDevice.properties.limits.nonCoherentAtomSize;
+        if (atomSize == 0) {
+            atomSize = 1;
+        }
+        VkDeviceSize begin = allocation.offset + offset;
+        VkDeviceSize end = size == VK_WHOLE_SIZE ? allocation.offset + allocation.size : begin + size;
+        begin = begin / atomSize * atomSize;
+        end = std::min((end + atomSize - 1) / atomSize * atomSize, allocation.offset + allocation.size);
+
         VkMappedMemoryRange mappedRange = {};
         mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
-        return vkInvalidateMappedMemoryRanges(vulkanDevice.device(), 1, &mappedRange);
+        mappedRange.memory = allocation.memory;
+        mappedRange.offset = begin;
+        mappedRange.size = end - begin;
+        return mappedRange;
     }
 
     /**
@@ -202,4 +246,43 @@ namespace VulkanEngine {
         return invalidate(alignmentSize, index * alignmentSize);
     }
 
+    /**
+     * Move the buffer into a fuller memory block so its current one can be released, recording the
+     * copy into commandBuffer
+     *
+     * @param commandBuffer Command buffer executed before anything reads the buffer this frame
+     * @param retiredBuffer Receives the old handle; destroy it once frames in flight are done with it
+     * @param retiredAllocation Receives the old allocation, to be passed to VulkanDevice::destroyBuffer
+     *
+     * @return false if the buffer can't be moved or no other block has room for it
+     *
+     * @note Only device-local buffers with transfer source and destination usage are moved; host
+     * visible ones may have pointers into their memory. Callers must not cache the VkBuffer handle.
+     */
+    bool VulkanBuffer::relocate(VkCommandBuffer commandBuffer, VkBuffer& retiredBuffer, VulkanAllocation& retiredAllocation) {
+        constexpr VkBufferUsageFlags transferUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        if ((memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) || (usageFlags & transferUsage) != transferUsage) {
+            return false;
+        }
+        if (!vulkanDevice.allocator().canReallocate(allocation)) {
+            return false;
+        }
+
+        VkBuffer newBuffer;
+        VulkanAllocation newAllocation{};
+        if (!vulkanDevice.createRelocatedBuffer(bufferSize, usageFlags, allocation, newBuffer, newAllocation)) {
+            return false;
+        }
+
+        VkBufferCopy copyRegion{};
+        copyRegion.size = bufferSize;
+        vkCmdCopyBuffer(commandBuffer, buffer, newBuffer, 1, &copyRegion);
+
+        retiredBuffer = buffer;
+        retiredAllocation = allocation;
+        buffer = newBuffer;
+        allocation = newAllocation;
+        return true;
+    }
+
 }  // namespace vulkan
\ No newline at end of file
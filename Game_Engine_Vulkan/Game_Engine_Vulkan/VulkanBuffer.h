@@ -11,6 +11,12 @@ namespace VulkanEngine {
             VkMemoryPropertyFlags memoryPropertyFlags,
             VkDeviceSize minOffsetAlignment = 1
         );
+        VulkanBuffer(VulkanDevice& device,
+            VkDeviceSize instanceSize,
+            uint32_t instanceCount, VkBufferUsageFlags usageFlags,
+            VulkanMemoryUsage memoryUsage,
+            VkDeviceSize minOffsetAlignment = 1
+        );
         ~VulkanBuffer();
 
         VulkanBuffer(const VulkanBuffer&) = delete;
@@ -29,22 +35,27 @@ namespace VulkanEngine {
         VkDescriptorBufferInfo descriptorInfoForIndex(int index);
         VkResult invalidateIndex(int index);
 
+        bool relocate(VkCommandBuffer commandBuffer, VkBuffer& retiredBuffer, VulkanAllocation& retiredAllocation);
+
         VkBuffer getBuffer() const { return buffer; }
         void* getMappedMemory() const { return mapped; }
         uint32_t getInstanceCount() const { return instanceCount; }
         VkDeviceSize getInstanceSize() const { return instanceSize; }
         VkDeviceSize getAlignmentSize() const { return alignmentSize; }
         VkBufferUsageFlags getUsageFlags() const { return usageFlags; }
+        // flags of the memory type the buffer ended up in, a superset of what was asked for
         VkMemoryPropertyFlags getMemoryPropertyFlags() const { return memoryPropertyFlags; }
         VkDeviceSize getBufferSize() const { return bufferSize; }
+        const VulkanAllocation& getAllocation() const { return allocation; }
 
     private:
         static VkDeviceSize getAlignment(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment);
+        VkMappedMemoryRange getMappedRange(VkDeviceSize size, VkDeviceSize offset);
 
         VulkanDevice& vulkanDevice;
         void* mapped = nullptr;
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VulkanAllocation allocation{};
 
         VkDeviceSize bufferSize;
         uint32_t instanceCount;
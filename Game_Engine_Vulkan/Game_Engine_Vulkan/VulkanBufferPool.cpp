@@ -0,0 +1,83 @@
+#include "VulkanBufferPool.h"
+
+// std
+#include <algorithm>
+
+namespace VulkanEngine {
+	VulkanBufferPool::VulkanBufferPool(VulkanDevice& device, size_t maxIdlePerClass)
+		: vulkanDevice{ device }, maxIdlePerClass{ maxIdlePerClass } {}
+
+	VulkanBufferPool::~VulkanBufferPool() {}
+
+	uint32_t VulkanBufferPool::sizeClass(VkDeviceSize size)
+	{
+		uint32_t sizeClass = MIN_SIZE_CLASS;
+		while ((VkDeviceSize{ 1 } << sizeClass) < size) {
+			sizeClass++;
+		}
+		return sizeClass;
+	}
+
+	std::unique_ptr<VulkanBuffer> VulkanBufferPool::acquire(
+		VkDeviceSize size, VkBufferUsageFlags usage, VulkanMemoryUsage memoryUsage)
+	{
+		uint32_t sizeClass = this->sizeClass(size);
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			auto bucket = idle.find(Key{ usage, memoryUsage, sizeClass });
+			if (bucket != idle.end() && !bucket->second.empty()) {
+				std::unique_ptr<VulkanBuffer> buffer = std::move(bucket->second.back());
+				bucket->second.pop_back();
+				hitCount++;
+				return buffer;
+			}
+			missCount++;
+		}
+		return std::make_unique<VulkanBuffer>(vulkanDevice, VkDeviceSize{ 1 } << sizeClass, 1, usage, memoryUsage);
+	}
+
+	void VulkanBufferPool::release(std::unique_ptr<VulkanBuffer> buffer, VulkanMemoryUsage memoryUsage, uint64_t lastUseValue)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		/* Buffers that weren't made here go under the largest class they can fully serve; ones too
+			small for any class are still held until the GPU is done, then destroyed. */
+		uint32_t sizeClass = this->sizeClass(buffer->getBufferSize());
+		if ((VkDeviceSize{ 1 } << sizeClass) > buffer->getBufferSize()) {
+			sizeClass--;
+		}
+
+		buffer->unmap();
+		Key key{ buffer->getUsageFlags(), memoryUsage, sizeClass };
+		retired.push_back(Retired{ key, std::move(buffer), lastUseValue });
+	}
+
+	void VulkanBufferPool::collect(uint64_t completedValue)
+	{
+		std::vector<std::unique_ptr<VulkanBuffer>> surplus;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+
+			auto done = std::partition(retired.begin(), retired.end(),
+				[completedValue](const Retired& entry) { return entry.value > completedValue; });
+			for (auto it = done; it != retired.end(); ++it) {
+				if (std::get<2>(it->key) >= MIN_SIZE_CLASS) {
+					auto& bucket = idle[it->key];
+					if (bucket.size() < maxIdlePerClass) {
+						bucket.push_back(std::move(it->buffer));
+						continue;
+					}
+				}
+				surplus.push_back(std::move(it->buffer));
+			}
+			retired.erase(done, retired.end());
+		}
+		// surplus buffers are destroyed here, outside the lock
+	}
+
+	void VulkanBufferPool::trim()
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		idle.clear();
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "VulkanBuffer.h"
+
+// std
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+namespace VulkanEngine {
+	/* Recycles VulkanBuffers instead of destroying and recreating them. Idle buffers are bucketed
+		by usage flags, memory usage and power-of-two size class, so a request is served by any
+		buffer of its class whatever size it was first made for. A released buffer is handed out
+		again only after collect() reports its last-use value complete; values come from whatever
+		tracks GPU progress (frame counter, timeline semaphore). */
+	class VulkanBufferPool {
+	public:
+		static constexpr uint32_t MIN_SIZE_CLASS = 8; // 256 bytes
+		// idle buffers kept per bucket; anything beyond is destroyed when it comes back
+		static constexpr size_t DEFAULT_MAX_IDLE_PER_CLASS = 2;
+
+		VulkanBufferPool(VulkanDevice& device, size_t maxIdlePerClass = DEFAULT_MAX_IDLE_PER_CLASS);
+		~VulkanBufferPool();
+
+		VulkanBufferPool(const VulkanBufferPool&) = delete;
+		VulkanBufferPool& operator=(const VulkanBufferPool&) = delete;
+
+		// The result holds at least size bytes; new buffers are made at the full size of the class
+		std::unique_ptr<VulkanBuffer> acquire(VkDeviceSize size, VkBufferUsageFlags usage, VulkanMemoryUsage memoryUsage);
+		// lastUseValue is the value after which the GPU no longer touches buffer
+		void release(std::unique_ptr<VulkanBuffer> buffer, VulkanMemoryUsage memoryUsage, uint64_t lastUseValue);
+		// Makes everything released with a value <= completedValue available again
+		void collect(uint64_t completedValue);
+		// Destroys every idle buffer; buffers still waiting on the GPU are kept
+		void trim();
+
+		uint64_t getHitCount() const { return hitCount; }
+		uint64_t getMissCount() const { return missCount; }
+
+	private:
+		using Key = std::tuple<VkBufferUsageFlags, VulkanMemoryUsage, uint32_t>;
+		struct Retired {
+			Key key;
+			std::unique_ptr<VulkanBuffer> buffer;
+			uint64_t value;
+		};
+
+		static uint32_t sizeClass(VkDeviceSize size);
+
+		VulkanDevice& vulkanDevice;
+		size_t maxIdlePerClass;
+		std::map<Key, std::vector<std::unique_ptr<VulkanBuffer>>> idle;
+		std::vector<Retired> retired;
+		uint64_t hitCount = 0;
+		uint64_t missCount = 0;
+		std::mutex mutex;
+	};
+}
@@ -0,0 +1,21 @@
+#include "VulkanCommandStats.h"
+
+namespace VulkanEngine {
+	VulkanCommandStats& VulkanCommandStats::operator+=(const VulkanCommandStats& other)
+	{
+		drawCalls += other.drawCalls;
+		pipelineBinds += other.pipelineBinds;
+		descriptorSetBinds += other.descriptorSetBinds;
+		pushConstantBytes += other.pushConstantBytes;
+		vertices += other.vertices;
+		indices += other.indices;
+		return *this;
+	}
+
+	void VulkanCommandStats::print(std::ostream& out) const
+	{
+		out << "Commands: " << drawCalls << " draws, " << pipelineBinds << " pipeline binds, "
+			<< descriptorSetBinds << " descriptor set binds, " << pushConstantBytes << " push constant bytes, "
+			<< vertices << " vertices, " << indices << " indices\n";
+	}
+}
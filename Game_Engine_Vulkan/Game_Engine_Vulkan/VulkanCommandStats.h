@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <ostream>
+
+namespace VulkanEngine {
+	// What a frame's command buffers asked the GPU to do, counted on the CPU while recording
+	struct VulkanCommandStats {
+		uint32_t drawCalls = 0;
+		uint32_t pipelineBinds = 0;
+		uint32_t descriptorSetBinds = 0; // sets, not vkCmdBindDescriptorSets calls
+		uint64_t pushConstantBytes = 0;
+		uint64_t vertices = 0;           // non-indexed draws, times their instance count
+		uint64_t indices = 0;            // indexed draws, times their instance count
+
+		VulkanCommandStats& operator+=(const VulkanCommandStats& other);
+		void print(std::ostream& out) const;
+	};
+
+	/* Thin wrappers around the vkCmd* calls the render systems make. Each records the command and
+		adds it to stats; a null stats records without counting. A VulkanCommandStats must only be
+		written by one thread, so parallel recordings each count into their own and get summed. */
+	namespace VulkanCommands {
+		inline void bindPipeline(
+			VulkanCommandStats* stats,
+			VkCommandBuffer commandBuffer,
+			VkPipelineBindPoint bindPoint,
+			VkPipeline pipeline) {
+			vkCmdBindPipeline(commandBuffer, bindPoint, pipeline);
+			if (stats) stats->pipelineBinds++;
+		}
+
+		inline void bindDescriptorSets(
+			VulkanCommandStats* stats,
+			VkCommandBuffer commandBuffer,
+			VkPipelineBindPoint bindPoint,
+			VkPipelineLayout layout,
+			uint32_t firstSet,
+			uint32_t setCount,
+			const VkDescriptorSet* descriptorSets,
+			uint32_t dynamicOffsetCount,
+			const uint32_t* dynamicOffsets) {
+			vkCmdBindDescriptorSets(
+				commandBuffer, bindPoint, layout, firstSet, setCount, descriptorSets, dynamicOffsetCount, dynamicOffsets);
+			if (stats) stats->descriptorSetBinds += setCount;
+		}
+
+		inline void pushConstants(
+			VulkanCommandStats* stats,
+			VkCommandBuffer commandBuffer,
+			VkPipelineLayout layout,
+			VkShaderStageFlags stageFlags,
+			uint32_t offset,
+			uint32_t size,
+			const void* values) {
+			vkCmdPushConstants(commandBuffer, layout, stageFlags, offset, size, values);
+			if (stats) stats->pushConstantBytes += size;
+		}
+
+		inline void draw(
+			VulkanCommandStats* stats,
+			VkCommandBuffer commandBuffer,
+			uint32_t vertexCount,
+			uint32_t instanceCount,
+			uint32_t firstVertex,
+			uint32_t firstInstance) {
+			vkCmdDraw(commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
+			if (stats) {
+				stats->drawCalls++;
+				stats->vertices += static_cast<uint64_t>(vertexCount) * instanceCount;
+			}
+		}
+
+		inline void drawIndexed(
+			VulkanCommandStats* stats,
+			VkCommandBuffer commandBuffer,
+			uint32_t indexCount,
+			uint32_t instanceCount,
+			uint32_t firstIndex,
+			int32_t vertexOffset,
+			uint32_t firstInstance) {
+			vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+			if (stats) {
+				stats->drawCalls++;
+				stats->indices += static_cast<uint64_t>(indexCount) * instanceCount;
+			}
+		}
+	}
+}
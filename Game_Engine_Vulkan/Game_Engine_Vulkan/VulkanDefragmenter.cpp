@@ -0,0 +1,147 @@
+#include "VulkanDefragmenter.h"
+
+// std
+#include <algorithm>
+#include <limits>
+
+namespace VulkanEngine {
+	VulkanDefragmenter::VulkanDefragmenter(VulkanDevice& device, uint32_t framesInFlight, VkDeviceSize bytesPerFrame)
+		: vulkanDevice{ device }, framesInFlight{ framesInFlight }, bytesPerFrame{ bytesPerFrame } {}
+
+	VulkanDefragmenter::~VulkanDefragmenter()
+	{
+		// the owner idles the device before tearing down, so nothing in flight is left to wait for
+		releaseRetired(std::numeric_limits<uint64_t>::max());
+	}
+
+	void VulkanDefragmenter::registerPool(VulkanGeometryPool& pool)
+	{
+		pools.push_back(&pool);
+	}
+
+	void VulkanDefragmenter::registerBuffer(VulkanBuffer& buffer)
+	{
+		buffers.push_back(&buffer);
+	}
+
+	void VulkanDefragmenter::unregisterBuffer(VulkanBuffer& buffer)
+	{
+		buffers.erase(std::remove(buffers.begin(), buffers.end(), &buffer), buffers.end());
+	}
+
+	VkDeviceSize VulkanDefragmenter::recordFrame(VkCommandBuffer commandBuffer)
+	{
+		frameNumber++;
+		if (frameNumber > framesInFlight) {
+			releaseRetired(frameNumber - framesInFlight);
+		}
+
+		// uploads still in flight may target the very ranges that would be moved
+		if (!vulkanDevice.uploader().isIdle()) {
+			return 0;
+		}
+
+		// one kind of move per frame; buffers only move once the pools are as compact as they get
+		VkDeviceSize bytesCopied = compactPools(commandBuffer);
+		if (bytesCopied == 0) {
+			bytesCopied = relocateBuffers(commandBuffer);
+		}
+
+		/* Destinations are storage nothing in flight reads any more, so the copies need no barrier
+			in front. Behind them, draws and later frames' moves must see what was written. */
+		if (bytesCopied > 0) {
+			VkMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+				VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+			vkCmdPipelineBarrier(
+				commandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+				0, 1, &barrier, 0, nullptr, 0, nullptr);
+		}
+
+		totalBytesMoved += bytesCopied;
+		return bytesCopied;
+	}
+
+	VkDeviceSize VulkanDefragmenter::compactPools(VkCommandBuffer commandBuffer)
+	{
+		VkDeviceSize bytesCopied = 0;
+		std::vector<VulkanGeometryPool::Range> vacated;
+		for (VulkanGeometryPool* pool : pools) {
+			if (bytesCopied >= bytesPerFrame) {
+				break;
+			}
+			bytesCopied += pool->compact(commandBuffer, bytesPerFrame - bytesCopied, vacated);
+			for (const auto& range : vacated) {
+				vacatedRanges.push_back({ pool, range, frameNumber });
+			}
+			vacated.clear();
+		}
+		return bytesCopied;
+	}
+
+	VkDeviceSize VulkanDefragmenter::relocateBuffers(VkCommandBuffer commandBuffer)
+	{
+		VulkanMemoryAllocator& allocator = vulkanDevice.allocator();
+
+		std::vector<VulkanBuffer*> candidates{ buffers };
+		for (VulkanGeometryPool* pool : pools) {
+			candidates.push_back(&pool->getVertexBuffer());
+			candidates.push_back(&pool->getIndexBuffer());
+		}
+
+		// emptiest blocks first, they are the closest to being freed
+		std::vector<std::pair<float, VulkanBuffer*>> sources;
+		for (VulkanBuffer* buffer : candidates) {
+			float utilization = allocator.blockUtilization(buffer->getAllocation());
+			if (utilization < MAX_SOURCE_UTILIZATION && buffer->getBufferSize() <= bytesPerFrame) {
+				sources.emplace_back(utilization, buffer);
+			}
+		}
+		std::sort(sources.begin(), sources.end(),
+			[](const auto& a, const auto& b) { return a.first < b.first; });
+
+		VkDeviceSize bytesCopied = 0;
+		for (const auto& source : sources) {
+			VulkanBuffer& buffer = *source.second;
+			if (bytesCopied + buffer.getBufferSize() > bytesPerFrame) {
+				continue;
+			}
+			RetiredBuffer retired{};
+			if (buffer.relocate(commandBuffer, retired.buffer, retired.allocation)) {
+				retired.frame = frameNumber;
+				retiredBuffers.push_back(retired);
+				bytesCopied += buffer.getBufferSize();
+			}
+		}
+		return bytesCopied;
+	}
+
+	void VulkanDefragmenter::releaseRetired(uint64_t completedFrame)
+	{
+		for (auto& vacated : vacatedRanges) {
+			if (vacated.frame <= completedFrame) {
+				vacated.pool->release(vacated.range);
+			}
+		}
+		vacatedRanges.erase(
+			std::remove_if(vacatedRanges.begin(), vacatedRanges.end(),
+				[completedFrame](const VacatedRange& vacated) { return vacated.frame <= completedFrame; }),
+			vacatedRanges.end());
+
+		auto done = std::partition(retiredBuffers.begin(), retiredBuffers.end(),
+			[completedFrame](const RetiredBuffer& retired) { return retired.frame > completedFrame; });
+		if (done == retiredBuffers.end()) {
+			return;
+		}
+		for (auto it = done; it != retiredBuffers.end(); ++it) {
+			vulkanDevice.destroyBuffer(it->buffer, it->allocation);
+		}
+		retiredBuffers.erase(done, retiredBuffers.end());
+		// blocks drained by the moves go back to the driver
+		vulkanDevice.allocator().releaseEmptyBlocks();
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "VulkanBuffer.h"
+#include "VulkanGeometryPool.h"
+
+// std
+#include <vector>
+
+namespace VulkanEngine {
+	/* Moves memory around a little every frame so storage that has become sparse can be handed
+		back: geometry ranges slide down into holes in their pool, and device-local buffers leave
+		mostly empty memory blocks for fuller ones. The copies go into the frame's own command buffer
+		ahead of the render pass and are capped at a byte budget, so the cost is spread over frames
+		instead of stalling one. Whatever was moved out of is released once every frame that could
+		still read it has finished. */
+	class VulkanDefragmenter {
+	public:
+		static constexpr VkDeviceSize DEFAULT_BYTES_PER_FRAME = 16 * 1024 * 1024;
+		// buffers in blocks fuller than this stay where they are
+		static constexpr float MAX_SOURCE_UTILIZATION = 0.5f;
+
+		// framesInFlight: how many frames after a move the old storage may still be read
+		VulkanDefragmenter(
+			VulkanDevice& device, uint32_t framesInFlight, VkDeviceSize bytesPerFrame = DEFAULT_BYTES_PER_FRAME);
+		~VulkanDefragmenter();
+
+		VulkanDefragmenter(const VulkanDefragmenter&) = delete;
+		VulkanDefragmenter& operator=(const VulkanDefragmenter&) = delete;
+
+		// Compacts the pool and relocates its vertex and index buffers
+		void registerPool(VulkanGeometryPool& pool);
+		// The buffer's users must look up getBuffer() every frame instead of caching the handle
+		void registerBuffer(VulkanBuffer& buffer);
+		void unregisterBuffer(VulkanBuffer& buffer);
+
+		/* Records this frame's share of the work. Call once per rendered frame, after beginFrame
+			and before the render pass begins, with this frame's uploads already queued.
+			Returns the bytes copied. */
+		VkDeviceSize recordFrame(VkCommandBuffer commandBuffer);
+
+		VkDeviceSize getBytesPerFrame() const { return bytesPerFrame; }
+		VkDeviceSize getTotalBytesMoved() const { return totalBytesMoved; }
+
+	private:
+		struct RetiredBuffer {
+			VkBuffer buffer;
+			VulkanAllocation allocation;
+			uint64_t frame;
+		};
+		struct VacatedRange {
+			VulkanGeometryPool* pool;
+			VulkanGeometryPool::Range range;
+			uint64_t frame;
+		};
+
+		void releaseRetired(uint64_t completedFrame);
+		VkDeviceSize compactPools(VkCommandBuffer commandBuffer);
+		VkDeviceSize relocateBuffers(VkCommandBuffer commandBuffer);
+
+		VulkanDevice& vulkanDevice;
+		uint32_t framesInFlight;
+		VkDeviceSize bytesPerFrame;
+		VkDeviceSize totalBytesMoved = 0;
+		uint64_t frameNumber = 0;
+
+		std::vector<VulkanGeometryPool*> pools;
+		std::vector<VulkanBuffer*> buffers;
+		std::vector<RetiredBuffer> retiredBuffers;
+		std::vector<VacatedRange> vacatedRanges;
+	};
+}
@@ -1,7 +1,10 @@
 #include "VulkanDevice.h"
+#include "VulkanStagingRing.h"
 
 // std headers
 #include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <set>
 #include <unordered_set>
@@ -46,6 +49,19 @@ void DestroyDebugUtilsMessengerEXT(
   }
 }
 
+static VulkanMemoryCategory bufferMemoryCategory(VkBufferUsageFlags usage) {
+  if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) {
+    return VulkanMemoryCategory::Uniform;
+  } else if (usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT) {
+    return VulkanMemoryCategory::Vertex;
+  } else if (usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT) {
+    return VulkanMemoryCategory::Index;
+  } else if (usage == VK_BUFFER_USAGE_TRANSFER_SRC_BIT) {
+    return VulkanMemoryCategory::Staging;
+  }
+  return VulkanMemoryCategory::Other;
+}
+
 // class member functions
 VulkanDevice::VulkanDevice(VulkanWindow &window) : window{window} {
   createInstance();
@@ -54,9 +70,18 @@ VulkanDevice::VulkanDevice(VulkanWindow &window) : window{window} {
   pickPhysicalDevice();
   createLogicalDevice();
   createCommandPool();
+  createAllocator();
+  createUploadResources();
+  createPipelineCache();
 }
 
 VulkanDevice::~VulkanDevice() {
+  savePipelineCache();
+  vkDestroyPipelineCache(device_, pipelineCache_, nullptr);
+  uploader_.reset();
+  stagingRing_.reset();
+  vkDestroyFence(device_, singleTimeFence_, nullptr);
+  allocator_.reset();
   vkDestroyCommandPool(device_, commandPool, nullptr);
   vkDestroyDevice(device_, nullptr);
 
@@ -79,7 +104,7 @@ void VulkanDevice::createInstance() {
   appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
   appInfo.pEngineName = "No Engine";
   appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-  appInfo.apiVersion = VK_API_VERSION_1_0;
+  appInfo.apiVersion = VK_API_VERSION_1_2;
 
   VkInstanceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -137,7 +162,10 @@ void VulkanDevice::createLogicalDevice() {
   QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
   std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-  std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+  std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.transferFamily};
+  if (!isHeadless()) {
+    uniqueQueueFamilies.insert(indices.presentFamily);
+  }
 
   float queuePriority = 1.0f;
   for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -149,18 +177,37 @@ void VulkanDevice::createLogicalDevice() {
     queueCreateInfos.push_back(queueCreateInfo);
   }
 
+  VkPhysicalDeviceFeatures supportedFeatures;
+  vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
   VkPhysicalDeviceFeatures deviceFeatures = {};
   deviceFeatures.samplerAnisotropy = VK_TRUE;
+  // optional: pipeline statistics queries, also while secondary command buffers execute
+  deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+  deviceFeatures.inheritedQueries = supportedFeatures.inheritedQueries;
+  pipelineStatisticsQuerySupported_ = supportedFeatures.pipelineStatisticsQuery == VK_TRUE;
+  inheritedQueriesSupported_ = supportedFeatures.inheritedQueries == VK_TRUE;
+
+  VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+  vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  vulkan12Features.timelineSemaphore = VK_TRUE;
 
   VkDeviceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  createInfo.pNext = &vulkan12Features;
 
   createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
   createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
   createInfo.pEnabledFeatures = &deviceFeatures;
-  createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-  createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+  std::vector<const char *> enabledExtensions = getDeviceExtensions();
+  memoryBudgetSupported_ =
+      isDeviceExtensionAvailable(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  if (memoryBudgetSupported_) {
+    enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  }
+  createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+  createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
   // might not really be necessary anymore because device specific validation layers
   // have been deprecated
@@ -176,7 +223,11 @@ void VulkanDevice::createLogicalDevice() {
   }
 
   vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
-  vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+  if (!isHeadless()) {
+    vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+  }
+  vkGetDeviceQueue(device_, indices.transferFamily, 0, &transferQueue_);
+  queueFamilyIndices_ = indices;
 }
 
 void VulkanDevice::createCommandPool() {
@@ -185,32 +236,138 @@ void VulkanDevice::createCommandPool() {
   VkCommandPoolCreateInfo poolInfo = {};
   poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
   poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
-  poolInfo.flags =
-      VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+  poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
 
   if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
     throw std::runtime_error("failed to create command pool!");
   }
+
+  // the pool only backs single-time commands, which are finished before the next one begins
+  VkCommandBufferAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  allocInfo.commandPool = commandPool;
+  allocInfo.commandBufferCount = 1;
+
+  if (vkAllocateCommandBuffers(device_, &allocInfo, &singleTimeCommandBuffer_) != VK_SUCCESS) {
+    throw std::runtime_error("failed to allocate command buffers!");
+  }
 }
 
-void VulkanDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
+void VulkanDevice::createAllocator() {
+  VkPhysicalDeviceMemoryProperties memProperties;
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+  allocator_ = std::make_unique<VulkanMemoryAllocator>(device_, memProperties, properties.limits);
+}
+
+void VulkanDevice::createUploadResources() {
+  VkFenceCreateInfo fenceInfo = {};
+  fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+  if (vkCreateFence(device_, &fenceInfo, nullptr, &singleTimeFence_) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create single time command fence!");
+  }
+  stagingRing_ = std::make_unique<VulkanStagingRing>(*this);
+  uploader_ = std::make_unique<VulkanUploader>(
+      *this, queueFamilyIndices_.transferFamily, transferQueue_);
+}
+
+void VulkanDevice::createPipelineCache() {
+  std::vector<char> data;
+  std::ifstream file{PIPELINE_CACHE_PATH, std::ios::ate | std::ios::binary};
+  if (file.is_open()) {
+    data.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(data.data(), data.size());
+    if (!file || !isPipelineCacheCompatible(data)) {
+      std::cout << "pipeline cache: ignoring " << PIPELINE_CACHE_PATH
+                << " (stale or from another device or driver)" << std::endl;
+      data.clear();
+    }
+  }
+
+  VkPipelineCacheCreateInfo cacheInfo = {};
+  cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  cacheInfo.initialDataSize = data.size();
+  cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+  if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &pipelineCache_) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create pipeline cache!");
+  }
+}
+
+// Drivers are meant to reject foreign data themselves, but some crash on it instead
+bool VulkanDevice::isPipelineCacheCompatible(const std::vector<char> &data) {
+  // VkPipelineCacheHeaderVersionOne: headerSize, headerVersion, vendorID, deviceID, pipelineCacheUUID
+  uint32_t header[4];
+  if (data.size() < sizeof(header) + VK_UUID_SIZE) {
+    return false;
+  }
+  std::memcpy(header, data.data(), sizeof(header));
+  return header[0] >= sizeof(header) + VK_UUID_SIZE && header[0] <= data.size() &&
+         header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE && header[2] == properties.vendorID &&
+         header[3] == properties.deviceID &&
+         std::memcmp(data.data() + sizeof(header), properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+// Runs from the destructor, so failures are reported rather than thrown
+void VulkanDevice::savePipelineCache() {
+  size_t size = 0;
+  if (vkGetPipelineCacheData(device_, pipelineCache_, &size, nullptr) != VK_SUCCESS || size == 0) {
+    return;
+  }
+  std::vector<char> data(size);
+  if (vkGetPipelineCacheData(device_, pipelineCache_, &size, data.data()) != VK_SUCCESS) {
+    std::cerr << "failed to read pipeline cache data!" << std::endl;
+    return;
+  }
+
+  // written beside the real file and renamed over it, so a crash or full disk can't leave it torn
+  const std::string tempPath = std::string{PIPELINE_CACHE_PATH} + ".tmp";
+  std::ofstream file{tempPath, std::ios::binary | std::ios::trunc};
+  file.write(data.data(), size);
+  file.close();
+  std::error_code error;
+  if (!file) {
+    std::cerr << "failed to write pipeline cache " << tempPath << "!" << std::endl;
+    std::filesystem::remove(tempPath, error);
+    return;
+  }
+  std::filesystem::rename(tempPath, PIPELINE_CACHE_PATH, error);
+  if (error) {
+    std::cerr << "failed to replace pipeline cache " << PIPELINE_CACHE_PATH << ": " << error.message()
+              << std::endl;
+    std::filesystem::remove(tempPath, error);
+  }
+}
+
+void VulkanDevice::createSurface() {
+  if (!window.isHeadless()) {
+    window.createWindowSurface(instance, &surface_);
+  }
+}
 
 bool VulkanDevice::isDeviceSuitable(VkPhysicalDevice device) {
   QueueFamilyIndices indices = findQueueFamilies(device);
 
   bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-  bool swapChainAdequate = false;
-  if (extensionsSupported) {
+  // headless rendering goes to offscreen images, so any device that can draw will do
+  bool swapChainAdequate = isHeadless();
+  if (extensionsSupported && !isHeadless()) {
     SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
     swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
   }
 
-  VkPhysicalDeviceFeatures supportedFeatures;
-  vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
+  VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+  vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  VkPhysicalDeviceFeatures2 supportedFeatures = {};
+  supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  supportedFeatures.pNext = &vulkan12Features;
+  vkGetPhysicalDeviceFeatures2(device, &supportedFeatures);
 
-  return indices.isComplete() && extensionsSupported && swapChainAdequate &&
-         supportedFeatures.samplerAnisotropy;
+  bool queuesComplete = isHeadless() ? indices.graphicsFamilyHasValue : indices.isComplete();
+  return queuesComplete && extensionsSupported && swapChainAdequate &&
+         supportedFeatures.features.samplerAnisotropy && vulkan12Features.timelineSemaphore;
 }
 
 void VulkanDevice::populateDebugMessengerCreateInfo(
@@ -261,11 +418,13 @@ bool VulkanDevice::checkValidationLayerSupport() {
 }
 
 std::vector<const char *> VulkanDevice::getRequiredExtensions() {
-  uint32_t glfwExtensionCount = 0;
-  const char **glfwExtensions;
-  glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-  std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  std::vector<const char *> extensions;
+  if (!window.isHeadless()) {
+    uint32_t glfwExtensionCount = 0;
+    const char **glfwExtensions;
+    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  }
 
   if (enableValidationLayers) {
     extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -308,6 +467,7 @@ bool VulkanDevice::checkDeviceExtensionSupport(VkPhysicalDevice device) {
       &extensionCount,
       availableExtensions.data());
 
+  std::vector<const char *> deviceExtensions = getDeviceExtensions();
   std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
 
   for (const auto &extension : availableExtensions) {
@@ -317,6 +477,32 @@ bool VulkanDevice::checkDeviceExtensionSupport(VkPhysicalDevice device) {
   return requiredExtensions.empty();
 }
 
+std::vector<const char *> VulkanDevice::getDeviceExtensions() {
+  if (isHeadless()) {
+    return {};
+  }
+  return deviceExtensions;
+}
+
+bool VulkanDevice::isDeviceExtensionAvailable(VkPhysicalDevice device, const char *extensionName) {
+  uint32_t extensionCount;
+  vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+  std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+  vkEnumerateDeviceExtensionProperties(
+      device,
+      nullptr,
+      &extensionCount,
+      availableExtensions.data());
+
+  for (const auto &extension : availableExtensions) {
+    if (strcmp(extension.extensionName, extensionName) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
 QueueFamilyIndices VulkanDevice::findQueueFamilies(VkPhysicalDevice device) {
   QueueFamilyIndices indices;
 
@@ -331,6 +517,14 @@ QueueFamilyIndices VulkanDevice::findQueueFamilies(VkPhysicalDevice device) {
     if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
       indices.graphicsFamily = i;
       indices.graphicsFamilyHasValue = true;
+      indices.graphicsTimestampValidBits = queueFamily.timestampValidBits;
+    }
+    if (isHeadless()) {
+      if (indices.graphicsFamilyHasValue) {
+        break;
+      }
+      i++;
+      continue;
     }
     VkBool32 presentSupport = false;
     vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
@@ -345,6 +539,22 @@ QueueFamilyIndices VulkanDevice::findQueueFamilies(VkPhysicalDevice device) {
     i++;
   }
 
+  // prefer a family that can only copy: it maps to the DMA engines on discrete GPUs
+  indices.transferFamily = indices.graphicsFamily;
+  int bestScore = -1;
+  for (uint32_t j = 0; j < queueFamilyCount; j++) {
+    VkQueueFlags flags = queueFamilies[j].queueFlags;
+    if (queueFamilies[j].queueCount == 0 || !(flags & VK_QUEUE_TRANSFER_BIT) ||
+        (flags & VK_QUEUE_GRAPHICS_BIT)) {
+      continue;
+    }
+    int score = (flags & VK_QUEUE_COMPUTE_BIT) ? 0 : 1;
+    if (score > bestScore) {
+      indices.transferFamily = j;
+      bestScore = score;
+    }
+  }
+
   return indices;
 }
 
@@ -391,58 +601,102 @@ VkFormat VulkanDevice::findSupportedFormat(
 }
 
 uint32_t VulkanDevice::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-  VkPhysicalDeviceMemoryProperties memProperties;
-  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
-  for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-    if ((typeFilter & (1 << i)) &&
-        (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-      return i;
-    }
-  }
-
-  throw std::runtime_error("failed to find suitable memory type!");
+  return allocator_->findMemoryType(typeFilter, properties);
 }
 
-void VulkanDevice::createBuffer(
-    VkDeviceSize size,
-    VkBufferUsageFlags usage,
-    VkMemoryPropertyFlags properties,
-    VkBuffer &buffer,
-    VkDeviceMemory &bufferMemory) {
+VkBuffer VulkanDevice::createBufferHandle(VkDeviceSize size, VkBufferUsageFlags usage) {
   VkBufferCreateInfo bufferInfo{};
   bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   bufferInfo.size = size;
   bufferInfo.usage = usage;
   bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+  // buffers the uploader copies into are shared with the transfer family, so no ownership transfer
+  uint32_t sharedFamilies[] = {queueFamilyIndices_.graphicsFamily, queueFamilyIndices_.transferFamily};
+  if (sharedFamilies[0] != sharedFamilies[1] &&
+      (usage & (VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT))) {
+    bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    bufferInfo.queueFamilyIndexCount = 2;
+    bufferInfo.pQueueFamilyIndices = sharedFamilies;
+  }
+
+  VkBuffer buffer;
   if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
     throw std::runtime_error("failed to create vertex buffer!");
   }
+  return buffer;
+}
+
+void VulkanDevice::createBuffer(
+    VkDeviceSize size,
+    VkBufferUsageFlags usage,
+    VkMemoryPropertyFlags properties,
+    VkBuffer &buffer,
+    VulkanAllocation &bufferAllocation) {
+  buffer = createBufferHandle(size, usage);
+
+  VkMemoryRequirements memRequirements;
+  vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
+
+  bufferAllocation =
+      allocator_->allocate(memRequirements, properties, true, bufferMemoryCategory(usage));
+
+  if (vkBindBufferMemory(device_, buffer, bufferAllocation.memory, bufferAllocation.offset) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to bind vertex buffer memory!");
+  }
+}
+
+void VulkanDevice::createBuffer(
+    VkDeviceSize size,
+    VkBufferUsageFlags usage,
+    VulkanMemoryUsage memoryUsage,
+    VkBuffer &buffer,
+    VulkanAllocation &bufferAllocation) {
+  buffer = createBufferHandle(size, usage);
 
   VkMemoryRequirements memRequirements;
   vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-  VkMemoryAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+  bufferAllocation =
+      allocator_->allocate(memRequirements, memoryUsage, true, bufferMemoryCategory(usage));
 
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-    throw std::runtime_error("failed to allocate vertex buffer memory!");
+  if (vkBindBufferMemory(device_, buffer, bufferAllocation.memory, bufferAllocation.offset) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to bind vertex buffer memory!");
   }
+}
 
-  vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+void VulkanDevice::destroyBuffer(VkBuffer buffer, VulkanAllocation &bufferAllocation) {
+  vkDestroyBuffer(device_, buffer, nullptr);
+  allocator_->free(bufferAllocation);
 }
 
-VkCommandBuffer VulkanDevice::beginSingleTimeCommands() {
-  VkCommandBufferAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-  allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-  allocInfo.commandPool = commandPool;
-  allocInfo.commandBufferCount = 1;
+bool VulkanDevice::createRelocatedBuffer(
+    VkDeviceSize size,
+    VkBufferUsageFlags usage,
+    const VulkanAllocation &currentAllocation,
+    VkBuffer &buffer,
+    VulkanAllocation &bufferAllocation) {
+  buffer = createBufferHandle(size, usage);
+
+  VkMemoryRequirements memRequirements;
+  vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
+  if (!allocator_->reallocate(currentAllocation, memRequirements, bufferAllocation)) {
+    vkDestroyBuffer(device_, buffer, nullptr);
+    buffer = VK_NULL_HANDLE;
+    return false;
+  }
+
+  if (vkBindBufferMemory(device_, buffer, bufferAllocation.memory, bufferAllocation.offset) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to bind vertex buffer memory!");
+  }
+  return true;
+}
 
-  VkCommandBuffer commandBuffer;
-  vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer);
+VkCommandBuffer VulkanDevice::beginSingleTimeCommands() {
+  VkCommandBuffer commandBuffer = singleTimeCommandBuffer_;
 
   VkCommandBufferBeginInfo beginInfo{};
   beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -460,18 +714,24 @@ void VulkanDevice::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
   submitInfo.commandBufferCount = 1;
   submitInfo.pCommandBuffers = &commandBuffer;
 
-  vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-  vkQueueWaitIdle(graphicsQueue_);
+  vkQueueSubmit(graphicsQueue_, 1, &submitInfo, singleTimeFence_);
+  vkWaitForFences(device_, 1, &singleTimeFence_, VK_TRUE, UINT64_MAX);
+  vkResetFences(device_, 1, &singleTimeFence_);
 
-  vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
+  vkResetCommandPool(device_, commandPool, 0);
 }
 
-void VulkanDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
+void VulkanDevice::copyBuffer(
+    VkBuffer srcBuffer,
+    VkBuffer dstBuffer,
+    VkDeviceSize size,
+    VkDeviceSize srcOffset,
+    VkDeviceSize dstOffset) {
   VkCommandBuffer commandBuffer = beginSingleTimeCommands();
 
   VkBufferCopy copyRegion{};
-  copyRegion.srcOffset = 0;  // Optional
-  copyRegion.dstOffset = 0;  // Optional
+  copyRegion.srcOffset = srcOffset;
+  copyRegion.dstOffset = dstOffset;
   copyRegion.size = size;
   vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
@@ -509,7 +769,8 @@ void VulkanDevice::createImageWithInfo(
     const VkImageCreateInfo &imageInfo,
     VkMemoryPropertyFlags properties,
     VkImage &image,
-    VkDeviceMemory &imageMemory) {
+    VulkanAllocation &imageAllocation,
+    VkMemoryPropertyFlags preferredProperties) {
   if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
     throw std::runtime_error("failed to create image!");
   }
@@ -517,18 +778,46 @@ void VulkanDevice::createImageWithInfo(
   VkMemoryRequirements memRequirements;
   vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-  VkMemoryAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+  if (allocator_->hasMemoryType(memRequirements.memoryTypeBits, properties | preferredProperties)) {
+    properties |= preferredProperties;
+  }
+  imageAllocation = allocator_->allocate(
+      memRequirements,
+      properties,
+      imageInfo.tiling == VK_IMAGE_TILING_LINEAR,
+      (imageInfo.usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) ? VulkanMemoryCategory::Depth
+                                                                      : VulkanMemoryCategory::Other);
+
+  if (vkBindImageMemory(device_, image, imageAllocation.memory, imageAllocation.offset) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to bind image memory!");
+  }
+}
+
+void VulkanDevice::destroyImage(VkImage image, VulkanAllocation &imageAllocation) {
+  vkDestroyImage(device_, image, nullptr);
+  allocator_->free(imageAllocation);
+}
 
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-    throw std::runtime_error("failed to allocate image memory!");
+VulkanMemoryStats VulkanDevice::getMemoryStats() {
+  VulkanMemoryStats stats = allocator_->getStats();
+  if (!memoryBudgetSupported_) {
+    return stats;
   }
 
-  if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
-    throw std::runtime_error("failed to bind image memory!");
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+  budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+  VkPhysicalDeviceMemoryProperties2 memProperties = {};
+  memProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+  memProperties.pNext = &budgetProperties;
+  vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &memProperties);
+
+  stats.budgetAvailable = true;
+  for (size_t i = 0; i < stats.memoryHeaps.size(); i++) {
+    stats.memoryHeaps[i].budget = budgetProperties.heapBudget[i];
+    stats.memoryHeaps[i].driverUsage = budgetProperties.heapUsage[i];
   }
+  return stats;
 }
 
 }  // namespace lve
\ No newline at end of file
@@ -1,13 +1,18 @@
 #pragma once
 
 #include "VulkanWindow.h"
+#include "VulkanMemoryAllocator.h"
+#include "VulkanUploader.h"
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace VulkanEngine {
 
+class VulkanStagingRing;
+
 struct SwapChainSupportDetails {
   VkSurfaceCapabilitiesKHR capabilities;
   std::vector<VkSurfaceFormatKHR> formats;
@@ -17,6 +22,8 @@ struct SwapChainSupportDetails {
 struct QueueFamilyIndices {
   uint32_t graphicsFamily;
   uint32_t presentFamily;
+  uint32_t transferFamily;  // same as graphicsFamily when there is no dedicated transfer family
+  uint32_t graphicsTimestampValidBits = 0;  // 0 if the graphics queue can't write timestamps
   bool graphicsFamilyHasValue = false;
   bool presentFamilyHasValue = false;
   bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
@@ -29,6 +36,8 @@ class VulkanDevice {
 #else
   const bool enableValidationLayers = true;
 #endif
+  // Relative to the working directory, like the shaders; loaded at startup, written back on destruction
+  static constexpr const char *PIPELINE_CACHE_PATH = "pipeline_cache.bin";
 
   VulkanDevice(VulkanWindow &window);
   ~VulkanDevice();
@@ -41,13 +50,22 @@ class VulkanDevice {
 
   VkCommandPool getCommandPool() { return commandPool; }
   VkDevice device() { return device_; }
+  // Without a surface (headless window) there is no present queue and no swapchain extension
   VkSurfaceKHR surface() { return surface_; }
+  bool isHeadless() const { return surface_ == VK_NULL_HANDLE; }
   VkQueue graphicsQueue() { return graphicsQueue_; }
   VkQueue presentQueue() { return presentQueue_; }
+  VkQueue transferQueue() { return transferQueue_; }
+  VulkanMemoryAllocator &allocator() { return *allocator_; }
+  VulkanStagingRing &stagingRing() { return *stagingRing_; }
+  VulkanUploader &uploader() { return *uploader_; }
+  // Every pipeline should be created through this so later launches skip the driver's compile
+  VkPipelineCache pipelineCache() { return pipelineCache_; }
 
   SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
   uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
   QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
+  uint32_t graphicsTimestampValidBits() const { return queueFamilyIndices_.graphicsTimestampValidBits; }
   VkFormat findSupportedFormat(
       const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
@@ -57,18 +75,47 @@ class VulkanDevice {
       VkBufferUsageFlags usage,
       VkMemoryPropertyFlags properties,
       VkBuffer &buffer,
-      VkDeviceMemory &bufferMemory);
+      VulkanAllocation &bufferAllocation);
+  // Lets the allocator rank memory types, e.g. to put Dynamic data in a (Re)BAR heap
+  void createBuffer(
+      VkDeviceSize size,
+      VkBufferUsageFlags usage,
+      VulkanMemoryUsage memoryUsage,
+      VkBuffer &buffer,
+      VulkanAllocation &bufferAllocation);
+  void destroyBuffer(VkBuffer buffer, VulkanAllocation &bufferAllocation);
+  // Creates a twin of a buffer in a fuller memory block (see VulkanMemoryAllocator::reallocate)
+  bool createRelocatedBuffer(
+      VkDeviceSize size,
+      VkBufferUsageFlags usage,
+      const VulkanAllocation &currentAllocation,
+      VkBuffer &buffer,
+      VulkanAllocation &bufferAllocation);
   VkCommandBuffer beginSingleTimeCommands();
   void endSingleTimeCommands(VkCommandBuffer commandBuffer);
-  void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+  void copyBuffer(
+      VkBuffer srcBuffer,
+      VkBuffer dstBuffer,
+      VkDeviceSize size,
+      VkDeviceSize srcOffset = 0,
+      VkDeviceSize dstOffset = 0);
   void copyBufferToImage(
       VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
 
+  // preferredProperties are added to properties when the image can live in such a memory type
   void createImageWithInfo(
       const VkImageCreateInfo &imageInfo,
       VkMemoryPropertyFlags properties,
       VkImage &image,
-      VkDeviceMemory &imageMemory);
+      VulkanAllocation &imageAllocation,
+      VkMemoryPropertyFlags preferredProperties = 0);
+  void destroyImage(VkImage image, VulkanAllocation &imageAllocation);
+
+  // Allocator statistics plus per-heap budgets from VK_EXT_memory_budget when it is available
+  VulkanMemoryStats getMemoryStats();
+  bool isMemoryBudgetSupported() const { return memoryBudgetSupported_; }
+  bool isPipelineStatisticsQuerySupported() const { return pipelineStatisticsQuerySupported_; }
+  bool isInheritedQueriesSupported() const { return inheritedQueriesSupported_; }
 
   VkPhysicalDeviceProperties properties;
 
@@ -79,6 +126,10 @@ class VulkanDevice {
   void pickPhysicalDevice();
   void createLogicalDevice();
   void createCommandPool();
+  void createAllocator();
+  void createUploadResources();
+  void createPipelineCache();
+  void savePipelineCache();
 
   // helper functions
   bool isDeviceSuitable(VkPhysicalDevice device);
@@ -88,6 +139,10 @@ class VulkanDevice {
   void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
   void hasGflwRequiredInstanceExtensions();
   bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+  std::vector<const char *> getDeviceExtensions();
+  bool isDeviceExtensionAvailable(VkPhysicalDevice device, const char *extensionName);
+  bool isPipelineCacheCompatible(const std::vector<char> &data);
+  VkBuffer createBufferHandle(VkDeviceSize size, VkBufferUsageFlags usage);
   SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
   VkInstance instance;
@@ -97,9 +152,20 @@ class VulkanDevice {
   VkCommandPool commandPool;
 
   VkDevice device_;
-  VkSurfaceKHR surface_;
+  VkSurfaceKHR surface_ = VK_NULL_HANDLE;
   VkQueue graphicsQueue_;
-  VkQueue presentQueue_;
+  VkQueue presentQueue_ = VK_NULL_HANDLE;
+  VkQueue transferQueue_;
+  QueueFamilyIndices queueFamilyIndices_;
+  std::unique_ptr<VulkanMemoryAllocator> allocator_;
+  std::unique_ptr<VulkanStagingRing> stagingRing_;
+  std::unique_ptr<VulkanUploader> uploader_;
+  VkFence singleTimeFence_ = VK_NULL_HANDLE;
+  VkCommandBuffer singleTimeCommandBuffer_ = VK_NULL_HANDLE;
+  VkPipelineCache pipelineCache_ = VK_NULL_HANDLE;
+  bool memoryBudgetSupported_ = false;
+  bool pipelineStatisticsQuerySupported_ = false;
+  bool inheritedQueriesSupported_ = false;
 
   const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
   const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
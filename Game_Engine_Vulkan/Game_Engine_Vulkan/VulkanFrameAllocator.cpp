@@ -0,0 +1,60 @@
+#include "VulkanFrameAllocator.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace VulkanEngine {
+	VulkanFrameAllocator::VulkanFrameAllocator(
+		VulkanDevice& device,
+		VkDeviceSize bytesPerFrame,
+		uint32_t frameCount,
+		VkBufferUsageFlags usageFlags)
+		: bytesPerFrame{ bytesPerFrame }
+	{
+		const VkPhysicalDeviceLimits& limits = device.properties.limits;
+		minAlignment = std::max<VkDeviceSize>(limits.minUniformBufferOffsetAlignment, 1);
+		if (usageFlags & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) {
+			minAlignment = std::max(minAlignment, limits.minStorageBufferOffsetAlignment);
+		}
+
+		// coherent, so slices never need flushing; device local too when the BAR is mappable
+		buffer = std::make_unique<VulkanBuffer>(
+			device,
+			bytesPerFrame,
+			frameCount,
+			usageFlags,
+			VulkanMemoryUsage::Dynamic,
+			minAlignment);
+		if (buffer->map() != VK_SUCCESS) {
+			throw std::runtime_error("failed to map frame allocator buffer!");
+		}
+		mapped = static_cast<char*>(buffer->getMappedMemory());
+
+		reset(0);
+	}
+
+	void VulkanFrameAllocator::reset(int frameIndex)
+	{
+		assert(frameIndex >= 0 && static_cast<uint32_t>(frameIndex) < buffer->getInstanceCount() &&
+			"Frame index out of range");
+		frameBegin = frameIndex * buffer->getAlignmentSize();
+		frameEnd = frameBegin + bytesPerFrame;
+		head = frameBegin;
+	}
+
+	VulkanFrameAllocator::Slice VulkanFrameAllocator::allocate(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		if (alignment == 0) {
+			alignment = minAlignment;
+		}
+		VkDeviceSize offset = (head + alignment - 1) / alignment * alignment;
+		if (offset + size > frameEnd) {
+			throw std::runtime_error("frame allocator ran out of space for this frame!");
+		}
+		head = offset + size;
+
+		return Slice{ offset, size, mapped + offset };
+	}
+}
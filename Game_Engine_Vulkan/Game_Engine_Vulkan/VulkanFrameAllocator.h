@@ -0,0 +1,63 @@
+#pragma once
+
+#include "VulkanBuffer.h"
+
+// std
+#include <cstring>
+#include <memory>
+
+namespace VulkanEngine {
+	/* Linear allocator for data that only lives for one frame (uniforms, streamed vertices, ...).
+		One persistently mapped buffer is split into a region per frame in flight; allocating is a
+		pointer bump and a region is recycled as soon as its frame's fence has been waited on. */
+	class VulkanFrameAllocator {
+	public:
+		struct Slice {
+			VkDeviceSize offset; // from the start of the buffer; usable as a dynamic descriptor offset
+			VkDeviceSize size;
+			void* data;
+		};
+
+		VulkanFrameAllocator(
+			VulkanDevice& device,
+			VkDeviceSize bytesPerFrame,
+			uint32_t frameCount,
+			VkBufferUsageFlags usageFlags =
+				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+				VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+
+		VulkanFrameAllocator(const VulkanFrameAllocator&) = delete;
+		VulkanFrameAllocator& operator=(const VulkanFrameAllocator&) = delete;
+
+		// Only call once the GPU is done with frameIndex's previous use
+		void reset(int frameIndex);
+
+		// alignment 0 uses minUniformBufferOffsetAlignment
+		Slice allocate(VkDeviceSize size, VkDeviceSize alignment = 0);
+
+		template <typename T>
+		Slice push(const T& value) {
+			Slice slice = allocate(sizeof(T));
+			std::memcpy(slice.data, &value, sizeof(T));
+			return slice;
+		}
+
+		VkBuffer getBuffer() const { return buffer->getBuffer(); }
+		VkDeviceSize getBytesPerFrame() const { return bytesPerFrame; }
+		VkDeviceSize getBytesUsed() const { return head - frameBegin; }
+		// range is the size each dynamic descriptor sees, starting at the dynamic offset
+		VkDescriptorBufferInfo descriptorInfo(VkDeviceSize range) { return buffer->descriptorInfo(range, 0); }
+
+	private:
+		VkDeviceSize bytesPerFrame;
+		VkDeviceSize minAlignment;
+		std::unique_ptr<VulkanBuffer> buffer;
+		char* mapped = nullptr;
+
+		VkDeviceSize frameBegin = 0;
+		VkDeviceSize frameEnd = 0;
+		VkDeviceSize head = 0;
+	};
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "VulkanCamera.h"
+#include "VulkanCommandStats.h"
+#include "VulkanFrameAllocator.h"
 #include "VulkanGameObject.h"
 // lib
 #include <vulkan/vulkan.h>
@@ -30,8 +32,11 @@ namespace VulkanEngine {
 		VkCommandBuffer commandBuffer;
 		VulkanCamera& camera;
 		VkDescriptorSet globalDescriptorSet;
+		uint32_t globalUboOffset; // dynamic offset of this frame's GlobalUbo
 		VulkanGameObject::Map& gameLightObjects;
 		VulkanGameObject::Map& gameMeshObjects;
 		VulkanGameObject& gamePlayer;
+		VulkanFrameAllocator& frameAllocator;
+		VulkanCommandStats* commandStats = nullptr; // counts what the systems record, if set
 	};
 }  // namespace lve
\ No newline at end of file
@@ -47,6 +47,8 @@ namespace VulkanEngine {
 
 		glm::vec3 color{};
 		TransformComponent transform{};
+		// Rarely moves: its draw may be replayed from a cached command buffer, re-recorded when it changes
+		bool isStatic = false;
 
 		// Optional pointer components.
 		std::shared_ptr<VulkanModel> model{}; // used by: SimpleRender
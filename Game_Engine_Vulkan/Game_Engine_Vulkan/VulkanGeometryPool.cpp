@@ -0,0 +1,295 @@
+#include "VulkanGeometryPool.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace VulkanEngine {
+	VulkanGeometryPool::VulkanGeometryPool(VulkanDevice& device, uint32_t vertexCapacity, uint32_t indexCapacity)
+		: vulkanDevice{ device }, vertexCapacity{ vertexCapacity }, indexCapacity{ indexCapacity }
+	{
+		vertexBuffer = createVertexBuffer(vertexCapacity);
+		indexBuffer = createIndexBuffer(indexCapacity);
+		freeVertices[0] = vertexCapacity;
+		freeIndices[0] = indexCapacity;
+	}
+
+	VulkanGeometryPool::~VulkanGeometryPool() {}
+
+	std::unique_ptr<VulkanBuffer> VulkanGeometryPool::createVertexBuffer(uint32_t capacity)
+	{
+		return std::make_unique<VulkanBuffer>(
+			vulkanDevice,
+			sizeof(VulkanModel::Vertex),
+			capacity,
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VulkanMemoryUsage::GpuOnly);
+	}
+
+	std::unique_ptr<VulkanBuffer> VulkanGeometryPool::createIndexBuffer(uint32_t capacity)
+	{
+		return std::make_unique<VulkanBuffer>(
+			vulkanDevice,
+			sizeof(uint32_t),
+			capacity,
+			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VulkanMemoryUsage::GpuOnly);
+	}
+
+	bool VulkanGeometryPool::takeRange(FreeList& freeList, uint32_t count, uint32_t& first)
+	{
+		if (count == 0) {
+			first = 0;
+			return true;
+		}
+		// best fit keeps large holes intact for large models
+		auto best = freeList.end();
+		for (auto it = freeList.begin(); it != freeList.end(); ++it) {
+			if (it->second >= count && (best == freeList.end() || it->second < best->second)) {
+				best = it;
+			}
+		}
+		if (best == freeList.end()) {
+			return false;
+		}
+
+		first = best->first;
+		uint32_t remaining = best->second - count;
+		freeList.erase(best);
+		if (remaining > 0) {
+			freeList[first + count] = remaining;
+		}
+		return true;
+	}
+
+	void VulkanGeometryPool::returnRange(FreeList& freeList, uint32_t first, uint32_t count)
+	{
+		if (count == 0) {
+			return;
+		}
+		auto next = freeList.lower_bound(first);
+		if (next != freeList.end() && first + count == next->first) {
+			count += next->second;
+			next = freeList.erase(next);
+		}
+		if (next != freeList.begin()) {
+			auto prev = std::prev(next);
+			if (prev->first + prev->second == first) {
+				prev->second += count;
+				return;
+			}
+		}
+		freeList[first] = count;
+	}
+
+	VulkanGeometryPool::Handle VulkanGeometryPool::allocate(
+		const std::vector<VulkanModel::Vertex>& vertices,
+		const std::vector<uint32_t>& indices,
+		VulkanUploadBatch* uploadBatch)
+	{
+		Range range{};
+		range.vertexCount = static_cast<uint32_t>(vertices.size());
+		range.indexCount = static_cast<uint32_t>(indices.size());
+		assert(range.vertexCount >= 3 && "Vertex count must be at least 3");
+
+		if (!takeRange(freeVertices, range.vertexCount, range.firstVertex)) {
+			reclaimRetiredRanges();
+			if (!takeRange(freeVertices, range.vertexCount, range.firstVertex)) {
+				grow(std::max(vertexCapacity * 2, vertexCapacity + range.vertexCount), indexCapacity, uploadBatch);
+				takeRange(freeVertices, range.vertexCount, range.firstVertex);
+			}
+		}
+		if (!takeRange(freeIndices, range.indexCount, range.firstIndex)) {
+			reclaimRetiredRanges();
+			if (!takeRange(freeIndices, range.indexCount, range.firstIndex)) {
+				grow(vertexCapacity, std::max(indexCapacity * 2, indexCapacity + range.indexCount), uploadBatch);
+				takeRange(freeIndices, range.indexCount, range.firstIndex);
+			}
+		}
+
+		auto upload = [&](const void* data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset) {
+			if (uploadBatch != nullptr) {
+				uploadBatch->uploadBuffer(data, size, dstBuffer, dstOffset);
+			}
+			else {
+				vulkanDevice.uploader().uploadBuffer(data, size, dstBuffer, dstOffset);
+			}
+		};
+		upload(
+			vertices.data(),
+			static_cast<VkDeviceSize>(range.vertexCount) * sizeof(VulkanModel::Vertex),
+			vertexBuffer->getBuffer(),
+			static_cast<VkDeviceSize>(range.firstVertex) * sizeof(VulkanModel::Vertex));
+		if (range.indexCount > 0) {
+			upload(
+				indices.data(),
+				static_cast<VkDeviceSize>(range.indexCount) * sizeof(uint32_t),
+				indexBuffer->getBuffer(),
+				static_cast<VkDeviceSize>(range.firstIndex) * sizeof(uint32_t));
+		}
+
+		Handle handle;
+		if (!freeHandles.empty()) {
+			handle = freeHandles.back();
+			freeHandles.pop_back();
+			ranges[handle] = range;
+		}
+		else {
+			handle = static_cast<Handle>(ranges.size());
+			ranges.push_back(range);
+		}
+		return handle;
+	}
+
+	void VulkanGeometryPool::free(Handle handle)
+	{
+		assert(handle < ranges.size() && "Invalid geometry handle");
+		Range& range = ranges[handle];
+		returnRange(retiredVertices, range.firstVertex, range.vertexCount);
+		returnRange(retiredIndices, range.firstIndex, range.indexCount);
+		range = Range{};
+		freeHandles.push_back(handle);
+	}
+
+	void VulkanGeometryPool::bind(VkCommandBuffer commandBuffer)
+	{
+		VkBuffer buffers[] = { vertexBuffer->getBuffer() };
+		VkDeviceSize offsets[] = { 0 };
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+		vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+	}
+
+	VkDeviceSize VulkanGeometryPool::compact(
+		VkCommandBuffer commandBuffer, VkDeviceSize byteBudget, std::vector<Range>& vacated)
+	{
+		VkDeviceSize bytesCopied = 0;
+		bool moved = true;
+		while (moved) {
+			moved = false;
+			Range vertexRange{};
+			VkDeviceSize bytes = compactStep(commandBuffer, byteBudget - bytesCopied, freeVertices, *vertexBuffer,
+				&Range::firstVertex, &Range::vertexCount, vertexRange);
+			if (bytes > 0) {
+				vacated.push_back(vertexRange);
+				bytesCopied += bytes;
+				moved = true;
+			}
+			Range indexRange{};
+			bytes = compactStep(commandBuffer, byteBudget - bytesCopied, freeIndices, *indexBuffer,
+				&Range::firstIndex, &Range::indexCount, indexRange);
+			if (bytes > 0) {
+				vacated.push_back(indexRange);
+				bytesCopied += bytes;
+				moved = true;
+			}
+		}
+		return bytesCopied;
+	}
+
+	VkDeviceSize VulkanGeometryPool::compactStep(
+		VkCommandBuffer commandBuffer,
+		VkDeviceSize byteBudget,
+		FreeList& freeList,
+		VulkanBuffer& buffer,
+		uint32_t Range::*first,
+		uint32_t Range::*count,
+		Range& vacated)
+	{
+		VkDeviceSize elementSize = buffer.getInstanceSize();
+
+		// walk live ranges from the back of the buffer until one has a lower hole it fits in
+		std::vector<Handle> live;
+		for (Handle handle = 0; handle < ranges.size(); handle++) {
+			if (ranges[handle].*count > 0) {
+				live.push_back(handle);
+			}
+		}
+		std::sort(live.begin(), live.end(), [&](Handle a, Handle b) { return ranges[a].*first > ranges[b].*first; });
+
+		for (Handle handle : live) {
+			Range& range = ranges[handle];
+			VkDeviceSize bytes = static_cast<VkDeviceSize>(range.*count) * elementSize;
+			if (bytes > byteBudget) {
+				continue;
+			}
+
+			auto hole = freeList.begin();
+			while (hole != freeList.end() && hole->first < range.*first && hole->second < range.*count) {
+				++hole;
+			}
+			if (hole == freeList.end() || hole->first >= range.*first) {
+				continue;
+			}
+
+			// the hole is free, so source and destination can't overlap within the one buffer
+			VkBufferCopy copyRegion{};
+			copyRegion.srcOffset = static_cast<VkDeviceSize>(range.*first) * elementSize;
+			copyRegion.dstOffset = static_cast<VkDeviceSize>(hole->first) * elementSize;
+			copyRegion.size = bytes;
+			vkCmdCopyBuffer(commandBuffer, buffer.getBuffer(), buffer.getBuffer(), 1, &copyRegion);
+
+			uint32_t newFirst = hole->first;
+			uint32_t remaining = hole->second - range.*count;
+			freeList.erase(hole);
+			if (remaining > 0) {
+				freeList[newFirst + range.*count] = remaining;
+			}
+
+			vacated.*first = range.*first;
+			vacated.*count = range.*count;
+			range.*first = newFirst;
+			version++;
+			return bytes;
+		}
+		return 0;
+	}
+
+	void VulkanGeometryPool::release(const Range& vacated)
+	{
+		returnRange(freeVertices, vacated.firstVertex, vacated.vertexCount);
+		returnRange(freeIndices, vacated.firstIndex, vacated.indexCount);
+	}
+
+	void VulkanGeometryPool::reclaimRetiredRanges()
+	{
+		if (retiredVertices.empty() && retiredIndices.empty()) {
+			return;
+		}
+		vkQueueWaitIdle(vulkanDevice.graphicsQueue());
+		for (auto& kv : retiredVertices) {
+			returnRange(freeVertices, kv.first, kv.second);
+		}
+		for (auto& kv : retiredIndices) {
+			returnRange(freeIndices, kv.first, kv.second);
+		}
+		retiredVertices.clear();
+		retiredIndices.clear();
+	}
+
+	void VulkanGeometryPool::grow(uint32_t minVertexCapacity, uint32_t minIndexCapacity, VulkanUploadBatch* uploadBatch)
+	{
+		// the old buffers can only go once nothing in flight references them, including recorded uploads
+		VulkanUploader& uploader = vulkanDevice.uploader();
+		uploader.wait(uploadBatch != nullptr ? uploadBatch->submit() : uploader.flush());
+		vkDeviceWaitIdle(vulkanDevice.device());
+		reclaimRetiredRanges();
+		version++;
+
+		if (minVertexCapacity > vertexCapacity) {
+			auto newBuffer = createVertexBuffer(minVertexCapacity);
+			vulkanDevice.copyBuffer(vertexBuffer->getBuffer(), newBuffer->getBuffer(), vertexBuffer->getBufferSize());
+			returnRange(freeVertices, vertexCapacity, minVertexCapacity - vertexCapacity);
+			vertexBuffer = std::move(newBuffer);
+			vertexCapacity = minVertexCapacity;
+		}
+		if (minIndexCapacity > indexCapacity) {
+			auto newBuffer = createIndexBuffer(minIndexCapacity);
+			vulkanDevice.copyBuffer(indexBuffer->getBuffer(), newBuffer->getBuffer(), indexBuffer->getBufferSize());
+			returnRange(freeIndices, indexCapacity, minIndexCapacity - indexCapacity);
+			indexBuffer = std::move(newBuffer);
+			indexCapacity = minIndexCapacity;
+		}
+	}
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "VulkanBuffer.h"
+#include "VulkanModel.h"
+
+// std
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace VulkanEngine {
+	/* Every model's vertices and indices live in one shared vertex buffer and one shared index
+		buffer, so they are bound once per frame instead of once per draw. Models keep a handle
+		into the pool's range table rather than raw offsets. */
+	class VulkanGeometryPool {
+	public:
+		using Handle = uint32_t;
+		static constexpr Handle INVALID_HANDLE = ~0u;
+
+		struct Range {
+			uint32_t firstVertex = 0;
+			uint32_t vertexCount = 0;
+			uint32_t firstIndex = 0;
+			uint32_t indexCount = 0;
+		};
+
+		static constexpr uint32_t DEFAULT_VERTEX_CAPACITY = 1 << 18;
+		static constexpr uint32_t DEFAULT_INDEX_CAPACITY = 1 << 20;
+
+		VulkanGeometryPool(
+			VulkanDevice& device,
+			uint32_t vertexCapacity = DEFAULT_VERTEX_CAPACITY,
+			uint32_t indexCapacity = DEFAULT_INDEX_CAPACITY);
+		~VulkanGeometryPool();
+
+		VulkanGeometryPool(const VulkanGeometryPool&) = delete;
+		VulkanGeometryPool& operator=(const VulkanGeometryPool&) = delete;
+
+		VulkanDevice& getDevice() const { return vulkanDevice; }
+
+		/* Data reaches the GPU through uploadBatch, or the device uploader's pending batch when null;
+			submit/flush it and wait on the ticket before drawing */
+		Handle allocate(
+			const std::vector<VulkanModel::Vertex>& vertices,
+			const std::vector<uint32_t>& indices,
+			VulkanUploadBatch* uploadBatch = nullptr);
+		void free(Handle handle);
+		const Range& getRange(Handle handle) const { return ranges[handle]; }
+
+		void bind(VkCommandBuffer commandBuffer);
+
+		/* Defragmentation: slides the highest vertex and index ranges down into holes nearer the
+			start of the buffers, recording the copies into commandBuffer and patching the range table
+			so models draw from the new place straight away. Copies at most byteBudget bytes and
+			returns how many it did. The ranges left behind are appended to vacated; hand them back
+			through release() once no frame in flight can read them. */
+		VkDeviceSize compact(VkCommandBuffer commandBuffer, VkDeviceSize byteBudget, std::vector<Range>& vacated);
+		void release(const Range& vacated);
+
+		// Changes whenever a range moves or the buffers are replaced, so recorded draws are stale
+		uint64_t getVersion() const { return version; }
+
+		uint32_t getVertexCapacity() const { return vertexCapacity; }
+		uint32_t getIndexCapacity() const { return indexCapacity; }
+		// the buffers may be replaced when the pool grows, so don't keep these around
+		VulkanBuffer& getVertexBuffer() const { return *vertexBuffer; }
+		VulkanBuffer& getIndexBuffer() const { return *indexBuffer; }
+
+	private:
+		// free lists map first element -> element count, kept coalesced
+		using FreeList = std::map<uint32_t, uint32_t>;
+
+		static bool takeRange(FreeList& freeList, uint32_t count, uint32_t& first);
+		static void returnRange(FreeList& freeList, uint32_t first, uint32_t count);
+		VkDeviceSize compactStep(
+			VkCommandBuffer commandBuffer,
+			VkDeviceSize byteBudget,
+			FreeList& freeList,
+			VulkanBuffer& buffer,
+			uint32_t Range::*first,
+			uint32_t Range::*count,
+			Range& vacated);
+		void reclaimRetiredRanges();
+		void grow(uint32_t minVertexCapacity, uint32_t minIndexCapacity, VulkanUploadBatch* uploadBatch);
+		std::unique_ptr<VulkanBuffer> createVertexBuffer(uint32_t capacity);
+		std::unique_ptr<VulkanBuffer> createIndexBuffer(uint32_t capacity);
+
+		VulkanDevice& vulkanDevice;
+		uint32_t vertexCapacity;
+		uint32_t indexCapacity;
+		std::unique_ptr<VulkanBuffer> vertexBuffer;
+		std::unique_ptr<VulkanBuffer> indexBuffer;
+		FreeList freeVertices;
+		FreeList freeIndices;
+		// freed ranges a frame in flight may still draw from; only reused after the GPU idles
+		FreeList retiredVertices;
+		FreeList retiredIndices;
+
+		std::vector<Range> ranges;
+		std::vector<Handle> freeHandles;
+		uint64_t version = 0;
+	};
+}
@@ -0,0 +1,317 @@
+#include "VulkanGpuProfiler.h"
+#include "Tracer.h"
+
+// std
+#include <algorithm>
+#include <iomanip>
+#include <stdexcept>
+
+namespace VulkanEngine {
+	VulkanGpuProfiler::VulkanGpuProfiler(
+		VulkanDevice& device,
+		uint32_t framesInFlight,
+		uint32_t maxScopesPerFrame,
+		size_t historyLength)
+		: device{ device },
+		maxScopes{ maxScopesPerFrame },
+		historyLength{ std::max<size_t>(historyLength, 1) }
+	{
+		uint32_t validBits = device.graphicsTimestampValidBits();
+		supported = validBits > 0 && maxScopes > 0;
+		timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+		millisecondsPerTick = device.properties.limits.timestampPeriod / 1e6;
+		statisticsSupported = device.isPipelineStatisticsQuerySupported();
+
+		if (supported) {
+			VkQueryPoolCreateInfo calibrationInfo{};
+			calibrationInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			calibrationInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			calibrationInfo.queryCount = 1;
+			if (vkCreateQueryPool(device.device(), &calibrationInfo, nullptr, &calibrationPool) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create timestamp query pool!");
+			}
+			results.resize(static_cast<size_t>(maxScopes) * 4);
+		}
+
+		frames.resize(framesInFlight);
+		for (auto& frame : frames) {
+			frame = std::make_unique<FrameQueries>();
+			if (supported) {
+				frame->names.resize(maxScopes);
+
+				VkQueryPoolCreateInfo poolInfo{};
+				poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+				poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+				poolInfo.queryCount = maxScopes * 2;
+				if (vkCreateQueryPool(device.device(), &poolInfo, nullptr, &frame->queryPool) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create timestamp query pool!");
+				}
+			}
+			if (statisticsSupported) {
+				VkQueryPoolCreateInfo poolInfo{};
+				poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+				poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+				poolInfo.queryCount = 1;
+				poolInfo.pipelineStatistics = PIPELINE_STATISTICS;
+				if (vkCreateQueryPool(device.device(), &poolInfo, nullptr, &frame->statisticsPool) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create pipeline statistics query pool!");
+				}
+			}
+		}
+	}
+
+	VulkanGpuProfiler::~VulkanGpuProfiler()
+	{
+		for (auto& frame : frames) {
+			if (frame->queryPool != VK_NULL_HANDLE) {
+				vkDestroyQueryPool(device.device(), frame->queryPool, nullptr);
+			}
+			if (frame->statisticsPool != VK_NULL_HANDLE) {
+				vkDestroyQueryPool(device.device(), frame->statisticsPool, nullptr);
+			}
+		}
+		if (calibrationPool != VK_NULL_HANDLE) {
+			vkDestroyQueryPool(device.device(), calibrationPool, nullptr);
+		}
+	}
+
+	void VulkanGpuProfiler::calibrate()
+	{
+		if (!supported) {
+			return;
+		}
+		VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+		vkCmdResetQueryPool(commandBuffer, calibrationPool, 0, 1);
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, calibrationPool, 0);
+		device.endSingleTimeCommands(commandBuffer);
+		// off by the time it takes the fence wait to return, which is well below a zone's length
+		calibrationNs = Tracer::now();
+
+		if (vkGetQueryPoolResults(
+			device.device(),
+			calibrationPool,
+			0,
+			1,
+			sizeof(calibrationTicks),
+			&calibrationTicks,
+			sizeof(calibrationTicks),
+			VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) != VK_SUCCESS) {
+			throw std::runtime_error("failed to get timestamp query results!");
+		}
+		calibrated = true;
+	}
+
+	int64_t VulkanGpuProfiler::toTracerTime(uint64_t ticks) const
+	{
+		// signed distance from the calibration point, in case the counter wrapped in between
+		uint64_t delta = (ticks - calibrationTicks) & timestampMask;
+		double signedDelta = delta > timestampMask / 2
+			? -static_cast<double>((timestampMask - delta) + 1)
+			: static_cast<double>(delta);
+		return calibrationNs + static_cast<int64_t>(signedDelta * millisecondsPerTick * 1e6);
+	}
+
+	void VulkanGpuProfiler::beginFrame(VkCommandBuffer commandBuffer, int frameIndex)
+	{
+		FrameQueries& frame = *frames[frameIndex];
+		// the resets also cover the first use of a pool, whose queries start out undefined
+		if (supported) {
+			collect(frame);
+			vkCmdResetQueryPool(commandBuffer, frame.queryPool, 0, maxScopes * 2);
+			frame.scopeCount.store(0, std::memory_order_relaxed);
+		}
+		if (statisticsSupported) {
+			collectPipelineStatistics(frame);
+			vkCmdResetQueryPool(commandBuffer, frame.statisticsPool, 0, 1);
+			frame.statisticsBegun = false;
+		}
+		currentFrame = frameIndex;
+	}
+
+	void VulkanGpuProfiler::collectAll()
+	{
+		// the slots are still reset by their next beginFrame, so nothing is collected twice
+		for (auto& frame : frames) {
+			if (supported) {
+				collect(*frame);
+				frame->scopeCount.store(0, std::memory_order_relaxed);
+			}
+			if (statisticsSupported) {
+				collectPipelineStatistics(*frame);
+				frame->statisticsBegun = false;
+			}
+		}
+	}
+
+	uint32_t VulkanGpuProfiler::beginScope(VkCommandBuffer commandBuffer, const char* name)
+	{
+		if (!supported || !enabled || currentFrame < 0) {
+			return INVALID_SCOPE;
+		}
+		FrameQueries& frame = *frames[currentFrame];
+		uint32_t scope = frame.scopeCount.fetch_add(1, std::memory_order_relaxed);
+		if (scope >= maxScopes) {
+			return INVALID_SCOPE;
+		}
+		frame.names[scope] = name;
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.queryPool, scope * 2);
+		return scope;
+	}
+
+	void VulkanGpuProfiler::endScope(VkCommandBuffer commandBuffer, uint32_t scope)
+	{
+		if (scope == INVALID_SCOPE) {
+			return;
+		}
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frames[currentFrame]->queryPool, scope * 2 + 1);
+	}
+
+	void VulkanGpuProfiler::beginPipelineStatistics(VkCommandBuffer commandBuffer)
+	{
+		if (!statisticsSupported || !enabled || currentFrame < 0) {
+			return;
+		}
+		FrameQueries& frame = *frames[currentFrame];
+		vkCmdBeginQuery(commandBuffer, frame.statisticsPool, 0, 0);
+		frame.statisticsBegun = true;
+	}
+
+	void VulkanGpuProfiler::endPipelineStatistics(VkCommandBuffer commandBuffer)
+	{
+		if (currentFrame < 0 || !frames[currentFrame]->statisticsBegun) {
+			return;
+		}
+		vkCmdEndQuery(commandBuffer, frames[currentFrame]->statisticsPool, 0);
+	}
+
+	bool VulkanGpuProfiler::getPipelineStatistics(PipelineStatistics& statistics) const
+	{
+		if (hasStatistics) {
+			statistics = latestStatistics;
+		}
+		return hasStatistics;
+	}
+
+	void VulkanGpuProfiler::collectPipelineStatistics(FrameQueries& frame)
+	{
+		if (!frame.statisticsBegun) {
+			return;
+		}
+		// one value per PIPELINE_STATISTICS bit, then the availability
+		uint64_t values[7] = {};
+		VkResult result = vkGetQueryPoolResults(
+			device.device(),
+			frame.statisticsPool,
+			0,
+			1,
+			sizeof(values),
+			values,
+			sizeof(values),
+			VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+		if (result != VK_SUCCESS && result != VK_NOT_READY) {
+			throw std::runtime_error("failed to get pipeline statistics query results!");
+		}
+		if (values[6] == 0) {
+			return;
+		}
+		latestStatistics.inputAssemblyVertices = values[0];
+		latestStatistics.inputAssemblyPrimitives = values[1];
+		latestStatistics.vertexShaderInvocations = values[2];
+		latestStatistics.clippingInvocations = values[3];
+		latestStatistics.clippingPrimitives = values[4];
+		latestStatistics.fragmentShaderInvocations = values[5];
+		hasStatistics = true;
+	}
+
+	void VulkanGpuProfiler::collect(FrameQueries& frame)
+	{
+		uint32_t scopeCount = std::min(frame.scopeCount.load(std::memory_order_relaxed), maxScopes);
+		if (scopeCount == 0) {
+			return;
+		}
+
+		// no WAIT_BIT: a scope whose queries aren't available (never ended, or still running) is skipped
+		VkResult result = vkGetQueryPoolResults(
+			device.device(),
+			frame.queryPool,
+			0,
+			scopeCount * 2,
+			scopeCount * 4 * sizeof(uint64_t),
+			results.data(),
+			2 * sizeof(uint64_t),
+			VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+		if (result != VK_SUCCESS && result != VK_NOT_READY) {
+			throw std::runtime_error("failed to get timestamp query results!");
+		}
+
+		bool tracing = calibrated && Tracer::isEnabled();
+		for (uint32_t scope = 0; scope < scopeCount; scope++) {
+			const uint64_t* query = &results[scope * 4]; // begin, available, end, available
+			if (query[1] == 0 || query[3] == 0) {
+				continue;
+			}
+			uint64_t ticks = (query[2] - query[0]) & timestampMask;
+			auto history = histories.find(frame.names[scope]);
+			if (history == histories.end()) {
+				history = histories.emplace(frame.names[scope], History{}).first;
+			}
+			history->second.frameTotal += ticks * millisecondsPerTick;
+			history->second.inFrame = true;
+			if (tracing) {
+				Tracer::recordGpu(
+					frame.names[scope], toTracerTime(query[0]), static_cast<int64_t>(ticks * millisecondsPerTick * 1e6));
+			}
+		}
+
+		for (auto& kv : histories) {
+			History& history = kv.second;
+			if (!history.inFrame) {
+				continue;
+			}
+			if (history.samples.size() < historyLength) {
+				history.samples.push_back(history.frameTotal);
+			}
+			else {
+				history.samples[history.next] = history.frameTotal;
+			}
+			history.next = (history.next + 1) % historyLength;
+			history.frameTotal = 0.0;
+			history.inFrame = false;
+		}
+	}
+
+	std::vector<VulkanGpuProfiler::ScopeStats> VulkanGpuProfiler::getStats() const
+	{
+		std::vector<ScopeStats> stats;
+		for (auto& kv : histories) {
+			if (!kv.second.samples.empty()) {
+				stats.push_back({ kv.first, SampleSummary::of(kv.second.samples) });
+			}
+		}
+		return stats;
+	}
+
+	void VulkanGpuProfiler::PipelineStatistics::print(std::ostream& out) const
+	{
+		out << "Pipeline statistics: " << inputAssemblyVertices << " vertices, " << inputAssemblyPrimitives
+			<< " primitives, " << vertexShaderInvocations << " vertex shader invocations, " << clippingInvocations
+			<< " clipping invocations, " << clippingPrimitives << " primitives after clipping, "
+			<< fragmentShaderInvocations << " fragment shader invocations\n";
+	}
+
+	void VulkanGpuProfiler::printStats(std::ostream& out) const
+	{
+		if (!supported) {
+			out << "GPU timings: timestamps not supported by the graphics queue\n";
+			return;
+		}
+		out << std::fixed << std::setprecision(3);
+		out << "GPU timings (ms over the last " << historyLength << " frames)\n";
+		for (auto& scope : getStats()) {
+			out << "  " << std::setw(20) << scope.name << ": avg " << scope.ms.mean
+				<< ", p50 " << scope.ms.p50 << ", p95 " << scope.ms.p95 << ", p99 " << scope.ms.p99
+				<< ", max " << scope.ms.max << " (" << scope.ms.count << " frames)\n";
+		}
+		out << std::defaultfloat;
+	}
+}
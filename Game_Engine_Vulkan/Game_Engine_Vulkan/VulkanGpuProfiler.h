@@ -0,0 +1,150 @@
+#pragma once
+
+#include "VulkanDevice.h"
+#include "SampleSummary.h"
+
+// std
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace VulkanEngine {
+	/* Times named scopes of a frame's command buffers with timestamp queries. Every frame in flight
+		has its own query pool, and a slot's results are only read when the slot comes around again:
+		by then the renderer has waited for that frame, so the readback never stalls. Pipeline
+		statistics, where the device has them, come back the same way. */
+	class VulkanGpuProfiler {
+	public:
+		static constexpr uint32_t DEFAULT_MAX_SCOPES = 64;  // per frame
+		static constexpr size_t DEFAULT_HISTORY_LENGTH = 240; // frames kept per scope for the statistics
+		static constexpr uint32_t INVALID_SCOPE = ~0u;
+		static constexpr VkQueryPipelineStatisticFlags PIPELINE_STATISTICS =
+			VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+		struct ScopeStats {
+			std::string name;
+			SampleSummary ms; // one sample per frame the scope ran in
+		};
+
+		// Results of a PIPELINE_STATISTICS query, in the order of the PIPELINE_STATISTICS bits
+		struct PipelineStatistics {
+			uint64_t inputAssemblyVertices = 0;
+			uint64_t inputAssemblyPrimitives = 0;
+			uint64_t vertexShaderInvocations = 0;
+			uint64_t clippingInvocations = 0;
+			uint64_t clippingPrimitives = 0;
+			uint64_t fragmentShaderInvocations = 0;
+
+			void print(std::ostream& out) const;
+		};
+
+		// Writes the begin timestamp on construction and the end timestamp on destruction
+		class Scope {
+		public:
+			Scope(VulkanGpuProfiler& profiler, VkCommandBuffer commandBuffer, const char* name)
+				: profiler{ profiler }, commandBuffer{ commandBuffer }, scope{ profiler.beginScope(commandBuffer, name) } {}
+			~Scope() { profiler.endScope(commandBuffer, scope); }
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+		private:
+			VulkanGpuProfiler& profiler;
+			VkCommandBuffer commandBuffer;
+			uint32_t scope;
+		};
+
+		VulkanGpuProfiler(
+			VulkanDevice& device,
+			uint32_t framesInFlight,
+			uint32_t maxScopesPerFrame = DEFAULT_MAX_SCOPES,
+			size_t historyLength = DEFAULT_HISTORY_LENGTH);
+		~VulkanGpuProfiler();
+
+		VulkanGpuProfiler(const VulkanGpuProfiler&) = delete;
+		VulkanGpuProfiler& operator=(const VulkanGpuProfiler&) = delete;
+
+		// false if the graphics queue has no timestamp support; scopes are then no-ops
+		bool isSupported() const { return supported; }
+		// false without the pipelineStatisticsQuery feature; the pipeline statistics calls are then no-ops
+		bool isPipelineStatisticsSupported() const { return statisticsSupported; }
+		bool isEnabled() const { return enabled; }
+		void setEnabled(bool enable) { enabled = enable; }
+
+		/* Lines GPU timestamps up with Tracer::now so collected scopes can go into a trace. Blocks on a
+			one-off submission, so call it when a capture starts rather than every frame. */
+		void calibrate();
+
+		/* Collects what this slot recorded framesInFlight frames ago and resets its queries. Call it
+			right after VulkanRenderer::beginFrame, before any render pass begins. */
+		void beginFrame(VkCommandBuffer commandBuffer, int frameIndex);
+		// Collects every frame slot's pending results; only once the device is idle
+		void collectAll();
+		/* Thread safe, so worker threads can time their secondary command buffers. name must outlive
+			the frame, a string literal in practice. Returns INVALID_SCOPE when the frame is full. */
+		uint32_t beginScope(VkCommandBuffer commandBuffer, const char* name);
+		void endScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+		/* Counts what the GPU does between the two calls, once per frame and outside of any render
+			pass. Secondary command buffers executed in between need inheritedQueries and
+			VulkanRenderer::setInheritedPipelineStatistics(PIPELINE_STATISTICS). */
+		void beginPipelineStatistics(VkCommandBuffer commandBuffer);
+		void endPipelineStatistics(VkCommandBuffer commandBuffer);
+		// The most recently collected frame's counts; false until there is one
+		bool getPipelineStatistics(PipelineStatistics& statistics) const;
+
+		// Sorted by name; a scope recorded several times in one frame counts as one sample of their sum
+		std::vector<ScopeStats> getStats() const;
+		void printStats(std::ostream& out) const;
+
+	private:
+		struct FrameQueries {
+			VkQueryPool queryPool = VK_NULL_HANDLE;
+			std::atomic<uint32_t> scopeCount{ 0 }; // handed out since the last reset, may exceed maxScopes
+			std::vector<const char*> names;        // per scope
+			VkQueryPool statisticsPool = VK_NULL_HANDLE;
+			bool statisticsBegun = false;
+		};
+		struct History {
+			std::vector<double> samples; // ring buffer, in milliseconds
+			size_t next = 0;
+			double frameTotal = 0.0;
+			bool inFrame = false;
+		};
+
+		void collect(FrameQueries& frame);
+		void collectPipelineStatistics(FrameQueries& frame);
+		// Tracer clock time of a raw timestamp; needs calibrate
+		int64_t toTracerTime(uint64_t ticks) const;
+
+		VulkanDevice& device;
+		uint32_t maxScopes;
+		size_t historyLength;
+		double millisecondsPerTick;
+		uint64_t timestampMask;
+		bool supported;
+		bool statisticsSupported;
+		bool enabled = true;
+		int currentFrame = -1;
+
+		VkQueryPool calibrationPool = VK_NULL_HANDLE;
+		uint64_t calibrationTicks = 0;
+		int64_t calibrationNs = 0;
+		bool calibrated = false;
+
+		std::vector<std::unique_ptr<FrameQueries>> frames;
+		std::map<std::string, History, std::less<>> histories;
+		std::vector<uint64_t> results; // scratch for vkGetQueryPoolResults
+		PipelineStatistics latestStatistics{};
+		bool hasStatistics = false;
+	};
+}
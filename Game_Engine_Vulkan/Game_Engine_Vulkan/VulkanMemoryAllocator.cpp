@@ -0,0 +1,545 @@
+#include "VulkanMemoryAllocator.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+#include <limits>
+#include <stdexcept>
+
+namespace VulkanEngine {
+	static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	static double toMiB(VkDeviceSize bytes) {
+		return static_cast<double>(bytes) / (1024.0 * 1024.0);
+	}
+
+	const char* memoryCategoryName(VulkanMemoryCategory category)
+	{
+		switch (category) {
+		case VulkanMemoryCategory::Vertex: return "vertex";
+		case VulkanMemoryCategory::Index: return "index";
+		case VulkanMemoryCategory::Uniform: return "uniform";
+		case VulkanMemoryCategory::Depth: return "depth";
+		case VulkanMemoryCategory::Staging: return "staging";
+		default: return "other";
+		}
+	}
+
+	bool VulkanMemoryStats::isOverBudget(float fraction) const
+	{
+		for (auto& heap : memoryHeaps) {
+			VkDeviceSize usage = std::max(heap.driverUsage, heap.blockBytes);
+			if (heap.budget > 0 && usage > static_cast<VkDeviceSize>(heap.budget * static_cast<double>(fraction))) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void VulkanMemoryStats::print(std::ostream& out) const
+	{
+		out << std::fixed << std::setprecision(2);
+		out << "GPU memory" << (budgetAvailable ? "" : " (no VK_EXT_memory_budget, budget = heap size)") << "\n";
+		for (size_t i = 0; i < memoryHeaps.size(); i++) {
+			auto& heap = memoryHeaps[i];
+			out << "  heap " << i << ": engine " << toMiB(heap.blockBytes) << " MiB";
+			if (budgetAvailable) {
+				out << ", process " << toMiB(heap.driverUsage) << " MiB";
+			}
+			out << " / budget " << toMiB(heap.budget) << " MiB (size " << toMiB(heap.size) << " MiB)\n";
+		}
+		for (size_t i = 0; i < memoryTypes.size(); i++) {
+			auto& type = memoryTypes[i];
+			if (type.blockCount == 0) continue;
+			out << "  type " << i << " (heap " << type.heapIndex << ", flags 0x" << std::hex << type.propertyFlags << std::dec
+				<< "): " << type.blockCount << " blocks, " << toMiB(type.blockBytes) << " MiB reserved, "
+				<< toMiB(type.used.bytes) << " MiB in " << type.used.allocationCount << " allocations\n";
+		}
+		for (size_t i = 0; i < categories.size(); i++) {
+			out << "  " << std::setw(8) << memoryCategoryName(static_cast<VulkanMemoryCategory>(i)) << ": "
+				<< toMiB(categories[i].bytes) << " MiB in " << categories[i].allocationCount << " allocations\n";
+		}
+		out << std::defaultfloat;
+	}
+
+	VulkanMemoryAllocator::VulkanMemoryAllocator(
+		VkDevice device,
+		const VkPhysicalDeviceMemoryProperties& memoryProperties,
+		const VkPhysicalDeviceLimits& limits,
+		VkDeviceSize preferredBlockSize)
+		: device{ device },
+		memoryProperties{ memoryProperties },
+		bufferImageGranularity{ std::max<VkDeviceSize>(limits.bufferImageGranularity, 1) },
+		nonCoherentAtomSize{ std::max<VkDeviceSize>(limits.nonCoherentAtomSize, 1) },
+		preferredBlockSize{ preferredBlockSize }
+	{
+		blocks.resize(memoryProperties.memoryTypeCount);
+	}
+
+	VulkanMemoryAllocator::~VulkanMemoryAllocator()
+	{
+		for (auto& typeBlocks : blocks) {
+			for (auto& block : typeBlocks) {
+				assert(block->allocationCount == 0 && "Memory block destroyed with live allocations");
+				if (!isSynthetic()) {
+					if (block->mapped) {
+						vkUnmapMemory(device, block->memory);
+					}
+					vkFreeMemory(device, block->memory, nullptr);
+				}
+			}
+		}
+	}
+
+	uint32_t VulkanMemoryAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+	{
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+			if ((typeFilter & (1 << i)) &&
+				(memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+				return i;
+			}
+		}
+
+		throw std::runtime_error("failed to find suitable memory type!");
+	}
+
+	uint32_t VulkanMemoryAllocator::findMemoryType(uint32_t typeFilter, VulkanMemoryUsage usage) const
+	{
+		VkMemoryPropertyFlags required = 0;
+		VkMemoryPropertyFlags preferred = 0;
+		VkMemoryPropertyFlags unwanted = 0;
+		switch (usage) {
+		case VulkanMemoryUsage::GpuOnly:
+			preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			unwanted = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+			break;
+		case VulkanMemoryUsage::Upload:
+			// the device-local host-visible window is left for Dynamic data
+			required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			unwanted = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+			break;
+		case VulkanMemoryUsage::Readback:
+			required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+			preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			break;
+		case VulkanMemoryUsage::Dynamic:
+			required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			unwanted = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+			break;
+		}
+
+		auto bitCount = [](VkMemoryPropertyFlags flags) {
+			int count = 0;
+			for (; flags != 0; flags &= flags - 1) count++;
+			return count;
+		};
+
+		uint32_t best = memoryProperties.memoryTypeCount;
+		int bestScore = 0;
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+			VkMemoryPropertyFlags flags = memoryProperties.memoryTypes[i].propertyFlags;
+			if (!(typeFilter & (1 << i)) || (flags & required) != required) continue;
+
+			// a preferred flag outweighs every unwanted one
+			int score = bitCount(flags & preferred) * 8 - bitCount(flags & unwanted);
+			if (best == memoryProperties.memoryTypeCount || score > bestScore) {
+				best = i;
+				bestScore = score;
+			}
+		}
+		if (best == memoryProperties.memoryTypeCount) {
+			throw std::runtime_error("failed to find suitable memory type!");
+		}
+		return best;
+	}
+
+	bool VulkanMemoryAllocator::hasMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+	{
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+			if ((typeFilter & (1 << i)) &&
+				(memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	VkDeviceSize VulkanMemoryAllocator::blockSizeForType(uint32_t memoryTypeIndex) const
+	{
+		// small heaps (e.g. the 256MB host-visible device-local window) get proportionally smaller blocks
+		uint32_t heapIndex = memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+		VkDeviceSize heapSize = memoryProperties.memoryHeaps[heapIndex].size;
+		if (heapSize <= 1024ull * 1024 * 1024) {
+			return std::min(preferredBlockSize, alignUp(heapSize / 8, 1024));
+		}
+		return preferredBlockSize;
+	}
+
+	VulkanMemoryBlock* VulkanMemoryAllocator::createBlock(uint32_t memoryTypeIndex, VkDeviceSize size, bool dedicated)
+	{
+		auto block = std::make_unique<VulkanMemoryBlock>();
+		block->size = size;
+		block->memoryTypeIndex = memoryTypeIndex;
+		block->dedicated = dedicated;
+		block->freeRanges[0] = size;
+
+		if (isSynthetic()) {
+			block->memory = (VkDeviceMemory)(uintptr_t)nextSyntheticHandle++;
+		}
+		else {
+			VkMemoryAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			allocInfo.allocationSize = size;
+			allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+			if (vkAllocateMemory(device, &allocInfo, nullptr, &block->memory) != VK_SUCCESS) {
+				throw std::runtime_error("failed to allocate device memory block!");
+			}
+
+			// a VkDeviceMemory may only be mapped once, so host-visible blocks stay mapped for their lifetime
+			if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+				if (vkMapMemory(device, block->memory, 0, VK_WHOLE_SIZE, 0, &block->mapped) != VK_SUCCESS) {
+					vkFreeMemory(device, block->memory, nullptr);
+					throw std::runtime_error("failed to map device memory block!");
+				}
+			}
+		}
+
+		blocks[memoryTypeIndex].push_back(std::move(block));
+		return blocks[memoryTypeIndex].back().get();
+	}
+
+	void VulkanMemoryAllocator::destroyBlock(VulkanMemoryBlock* block)
+	{
+		if (!isSynthetic()) {
+			if (block->mapped) {
+				vkUnmapMemory(device, block->memory);
+			}
+			vkFreeMemory(device, block->memory, nullptr);
+		}
+
+		auto& typeBlocks = blocks[block->memoryTypeIndex];
+		typeBlocks.erase(std::find_if(typeBlocks.begin(), typeBlocks.end(),
+			[block](const std::unique_ptr<VulkanMemoryBlock>& b) { return b.get() == block; }));
+	}
+
+	bool VulkanMemoryAllocator::allocateFromBlock(
+		VulkanMemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment, VulkanAllocation& allocation)
+	{
+		// best fit: the free range that leaves the least space behind
+		auto best = block.freeRanges.end();
+		VkDeviceSize bestOffset = 0;
+		VkDeviceSize bestWaste = std::numeric_limits<VkDeviceSize>::max();
+		for (auto it = block.freeRanges.begin(); it != block.freeRanges.end(); ++it) {
+			VkDeviceSize alignedOffset = alignUp(it->first, alignment);
+			VkDeviceSize padding = alignedOffset - it->first;
+			if (padding + size > it->second) continue;
+
+			VkDeviceSize waste = it->second - size;
+			if (waste < bestWaste) {
+				best = it;
+				bestOffset = alignedOffset;
+				bestWaste = waste;
+			}
+		}
+		if (best == block.freeRanges.end()) {
+			return false;
+		}
+
+		VkDeviceSize rangeOffset = best->first;
+		VkDeviceSize rangeEnd = best->first + best->second;
+		block.freeRanges.erase(best);
+		// alignment padding in front and the tail of the range go back on the free list
+		if (bestOffset > rangeOffset) {
+			block.freeRanges[rangeOffset] = bestOffset - rangeOffset;
+		}
+		if (rangeEnd > bestOffset + size) {
+			block.freeRanges[bestOffset + size] = rangeEnd - (bestOffset + size);
+		}
+
+		block.usedBytes += size;
+		block.allocationCount++;
+
+		allocation.memory = block.memory;
+		allocation.offset = bestOffset;
+		allocation.size = size;
+		allocation.memoryTypeIndex = block.memoryTypeIndex;
+		allocation.mapped = block.mapped ? static_cast<char*>(block.mapped) + bestOffset : nullptr;
+		allocation.block = &block;
+		return true;
+	}
+
+	VulkanAllocation VulkanMemoryAllocator::allocate(
+		const VkMemoryRequirements& requirements,
+		VkMemoryPropertyFlags properties,
+		bool linear,
+		VulkanMemoryCategory category)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return allocateFromType(findMemoryType(requirements.memoryTypeBits, properties), requirements, linear, category);
+	}
+
+	VulkanAllocation VulkanMemoryAllocator::allocate(
+		const VkMemoryRequirements& requirements,
+		VulkanMemoryUsage usage,
+		bool linear,
+		VulkanMemoryCategory category)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return allocateFromType(findMemoryType(requirements.memoryTypeBits, usage), requirements, linear, category);
+	}
+
+	VulkanAllocation VulkanMemoryAllocator::allocateFromType(
+		uint32_t memoryTypeIndex,
+		const VkMemoryRequirements& requirements,
+		bool linear,
+		VulkanMemoryCategory category)
+	{
+		VkMemoryPropertyFlags typeFlags = memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+
+		VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+		VkDeviceSize size = requirements.size;
+		if (!linear) {
+			/* Optimal-tiled images own whole bufferImageGranularity pages, so a buffer can never
+				end up sharing a page with one no matter which neighbours it is placed between. */
+			alignment = std::max(alignment, bufferImageGranularity);
+			size = alignUp(size, bufferImageGranularity);
+		}
+		if ((typeFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(typeFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+			// keep flush/invalidate ranges of neighbouring allocations from overlapping
+			alignment = std::max(alignment, nonCoherentAtomSize);
+			size = alignUp(size, nonCoherentAtomSize);
+		}
+
+		VulkanAllocation allocation{};
+		VkDeviceSize blockSize = blockSizeForType(memoryTypeIndex);
+		bool placed = false;
+		if (size > blockSize / 2) {
+			VulkanMemoryBlock* block = createBlock(memoryTypeIndex, size, true);
+			placed = allocateFromBlock(*block, size, alignment, allocation);
+		}
+		else {
+			for (auto& block : blocks[memoryTypeIndex]) {
+				if (!block->dedicated && allocateFromBlock(*block, size, alignment, allocation)) {
+					placed = true;
+					break;
+				}
+			}
+			if (!placed) {
+				VulkanMemoryBlock* block = createBlock(memoryTypeIndex, blockSize, false);
+				placed = allocateFromBlock(*block, size, alignment, allocation);
+			}
+		}
+
+		// only count the allocation once it has memory; createBlock throws when vkAllocateMemory fails
+		if (placed) {
+			allocation.category = category;
+			auto& usage = categoryUsage[static_cast<size_t>(category)];
+			usage.bytes += size;
+			usage.allocationCount++;
+		}
+		return allocation;
+	}
+
+	void VulkanMemoryAllocator::free(VulkanAllocation& allocation)
+	{
+		if (allocation.block == nullptr) {
+			return;
+		}
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		VulkanMemoryBlock* block = allocation.block;
+		VkDeviceSize offset = allocation.offset;
+		VkDeviceSize size = allocation.size;
+		auto& usage = categoryUsage[static_cast<size_t>(allocation.category)];
+		usage.bytes -= size;
+		usage.allocationCount--;
+		block->usedBytes -= size;
+		block->allocationCount--;
+		allocation = VulkanAllocation{};
+
+		// merge with the neighbouring free ranges
+		auto next = block->freeRanges.lower_bound(offset);
+		if (next != block->freeRanges.end() && offset + size == next->first) {
+			size += next->second;
+			next = block->freeRanges.erase(next);
+		}
+		if (next != block->freeRanges.begin()) {
+			auto prev = std::prev(next);
+			if (prev->first + prev->second == offset) {
+				prev->second += size;
+				size = 0;
+			}
+		}
+		if (size > 0) {
+			block->freeRanges[offset] = size;
+		}
+
+		if (block->allocationCount > 0) {
+			return;
+		}
+		// keep at most one empty block per memory type around so alloc/free churn doesn't hit the driver
+		bool otherEmptyBlock = false;
+		for (auto& other : blocks[block->memoryTypeIndex]) {
+			if (other.get() != block && !other->dedicated && other->allocationCount == 0) {
+				otherEmptyBlock = true;
+			}
+		}
+		if (block->dedicated || otherEmptyBlock) {
+			destroyBlock(block);
+		}
+	}
+
+	bool VulkanMemoryAllocator::reallocate(
+		const VulkanAllocation& current, const VkMemoryRequirements& requirements, VulkanAllocation& moved)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		VulkanMemoryBlock* source = current.block;
+		if (source == nullptr || source->dedicated ||
+			!(requirements.memoryTypeBits & (1u << current.memoryTypeIndex))) {
+			return false;
+		}
+
+		VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+		VkDeviceSize size = std::max(requirements.size, current.size);
+
+		// fill the fullest blocks first so the emptiest ones are the ones that drain
+		std::vector<VulkanMemoryBlock*> targets;
+		for (auto& block : blocks[current.memoryTypeIndex]) {
+			if (block.get() != source && !block->dedicated && block->usedBytes >= source->usedBytes) {
+				targets.push_back(block.get());
+			}
+		}
+		std::sort(targets.begin(), targets.end(), [](const VulkanMemoryBlock* a, const VulkanMemoryBlock* b) {
+			return a->usedBytes * b->size > b->usedBytes * a->size;
+		});
+
+		for (VulkanMemoryBlock* block : targets) {
+			if (allocateFromBlock(*block, size, alignment, moved)) {
+				moved.category = current.category;
+				auto& usage = categoryUsage[static_cast<size_t>(current.category)];
+				usage.bytes += size;
+				usage.allocationCount++;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool VulkanMemoryAllocator::canReallocate(const VulkanAllocation& current) const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		VulkanMemoryBlock* source = current.block;
+		if (source == nullptr || source->dedicated) {
+			return false;
+		}
+		for (auto& block : blocks[current.memoryTypeIndex]) {
+			if (block.get() == source || block->dedicated || block->usedBytes < source->usedBytes) {
+				continue;
+			}
+			for (auto& range : block->freeRanges) {
+				if (range.second >= current.size) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	float VulkanMemoryAllocator::blockUtilization(const VulkanAllocation& allocation) const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		if (allocation.block == nullptr || allocation.block->size == 0) {
+			return 0.f;
+		}
+		return static_cast<float>(allocation.block->usedBytes) / static_cast<float>(allocation.block->size);
+	}
+
+	void VulkanMemoryAllocator::releaseEmptyBlocks()
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		for (auto& typeBlocks : blocks) {
+			std::vector<VulkanMemoryBlock*> empty;
+			for (auto& block : typeBlocks) {
+				if (block->allocationCount == 0) {
+					empty.push_back(block.get());
+				}
+			}
+			for (VulkanMemoryBlock* block : empty) {
+				destroyBlock(block);
+			}
+		}
+	}
+
+	bool VulkanMemoryAllocator::validate() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		for (auto& typeBlocks : blocks) {
+			for (auto& block : typeBlocks) {
+				VkDeviceSize freeBytes = 0;
+				VkDeviceSize previousEnd = 0;
+				bool first = true;
+				for (auto& range : block->freeRanges) {
+					if (range.second == 0 || range.first + range.second > block->size) return false;
+					// ranges must be disjoint and never directly adjacent (adjacent ones get merged)
+					if (!first && range.first <= previousEnd) return false;
+					previousEnd = range.first + range.second;
+					freeBytes += range.second;
+					first = false;
+				}
+				if (block->allocationCount == 0 && block->usedBytes != 0) return false;
+				if (block->usedBytes + freeBytes != block->size) return false;
+			}
+		}
+		return true;
+	}
+
+	VulkanMemoryStats VulkanMemoryAllocator::getStats() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		VulkanMemoryStats stats{};
+		stats.memoryHeaps.resize(memoryProperties.memoryHeapCount);
+		for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+			stats.memoryHeaps[i].size = memoryProperties.memoryHeaps[i].size;
+			stats.memoryHeaps[i].budget = memoryProperties.memoryHeaps[i].size;
+		}
+
+		stats.memoryTypes.resize(memoryProperties.memoryTypeCount);
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+			auto& type = stats.memoryTypes[i];
+			type.propertyFlags = memoryProperties.memoryTypes[i].propertyFlags;
+			type.heapIndex = memoryProperties.memoryTypes[i].heapIndex;
+			for (auto& block : blocks[i]) {
+				type.blockCount++;
+				type.blockBytes += block->size;
+				type.used.bytes += block->usedBytes;
+				type.used.allocationCount += block->allocationCount;
+			}
+			stats.memoryHeaps[type.heapIndex].blockBytes += type.blockBytes;
+		}
+
+		stats.categories = categoryUsage;
+		return stats;
+	}
+
+	size_t VulkanMemoryAllocator::blockCount() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		size_t count = 0;
+		for (auto& typeBlocks : blocks) {
+			count += typeBlocks.size();
+		}
+		return count;
+	}
+}
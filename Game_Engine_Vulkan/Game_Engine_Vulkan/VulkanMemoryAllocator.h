@@ -0,0 +1,167 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace VulkanEngine {
+	// What an allocation is used for; only drives statistics.
+	enum class VulkanMemoryCategory { Vertex, Index, Uniform, Depth, Staging, Other, Count };
+
+	const char* memoryCategoryName(VulkanMemoryCategory category);
+
+	// How the CPU and GPU access an allocation; picks the memory type instead of raw property flags.
+	enum class VulkanMemoryUsage {
+		GpuOnly,  // only the GPU touches it: device local, ideally not host visible
+		Upload,   // written once by the CPU, read once by the GPU: host coherent, kept out of the BAR
+		Readback, // written by the GPU, read by the CPU: host visible, ideally cached
+		Dynamic   // rewritten by the CPU every frame and read in place: device local and mapped when there is a (Re)BAR heap
+	};
+
+	struct VulkanMemoryStats {
+		struct Usage {
+			VkDeviceSize bytes = 0;
+			uint32_t allocationCount = 0;
+		};
+		struct TypeStats {
+			VkMemoryPropertyFlags propertyFlags = 0;
+			uint32_t heapIndex = 0;
+			uint32_t blockCount = 0;
+			VkDeviceSize blockBytes = 0; // allocated from the driver
+			Usage used{};                // handed out to buffers and images
+		};
+		struct HeapStats {
+			VkDeviceSize size = 0;
+			VkDeviceSize blockBytes = 0;
+			VkDeviceSize budget = 0;     // from VK_EXT_memory_budget, otherwise the heap size
+			VkDeviceSize driverUsage = 0; // whole process according to the driver, 0 if unknown
+		};
+
+		std::vector<TypeStats> memoryTypes;
+		std::vector<HeapStats> memoryHeaps;
+		std::array<Usage, static_cast<size_t>(VulkanMemoryCategory::Count)> categories{};
+		bool budgetAvailable = false;
+
+		const Usage& category(VulkanMemoryCategory c) const { return categories[static_cast<size_t>(c)]; }
+		// true if any heap uses more than fraction of its budget
+		bool isOverBudget(float fraction = 1.f) const;
+		void print(std::ostream& out) const;
+	};
+
+	// One vkAllocateMemory call, carved up into many allocations.
+	struct VulkanMemoryBlock {
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize size = 0;
+		uint32_t memoryTypeIndex = 0;
+		void* mapped = nullptr; // persistently mapped when the memory type is host visible
+		bool dedicated = false; // holds a single allocation too large to share a block
+
+		VkDeviceSize usedBytes = 0;
+		uint32_t allocationCount = 0;
+		std::map<VkDeviceSize, VkDeviceSize> freeRanges{}; // offset -> size, kept coalesced
+	};
+
+	// A range of a shared VkDeviceMemory block handed out by VulkanMemoryAllocator.
+	struct VulkanAllocation {
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0; // reserved size, including any granularity padding
+		uint32_t memoryTypeIndex = 0;
+		void* mapped = nullptr; // host pointer to offset, if the block is host visible
+		VulkanMemoryBlock* block = nullptr;
+		VulkanMemoryCategory category = VulkanMemoryCategory::Other;
+	};
+
+	class VulkanMemoryAllocator {
+	public:
+		static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+		/* With device == VK_NULL_HANDLE the allocator runs purely on the CPU: blocks get synthetic
+			VkDeviceMemory handles and are never mapped, so it can be driven with made-up memory
+			types and memory requirements without a GPU. */
+		VulkanMemoryAllocator(
+			VkDevice device,
+			const VkPhysicalDeviceMemoryProperties& memoryProperties,
+			const VkPhysicalDeviceLimits& limits,
+			VkDeviceSize preferredBlockSize = DEFAULT_BLOCK_SIZE);
+		~VulkanMemoryAllocator();
+
+		VulkanMemoryAllocator(const VulkanMemoryAllocator&) = delete;
+		VulkanMemoryAllocator& operator=(const VulkanMemoryAllocator&) = delete;
+
+		uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+		// Best ranked type for usage: every required flag, most preferred ones, fewest unwanted ones
+		uint32_t findMemoryType(uint32_t typeFilter, VulkanMemoryUsage usage) const;
+		bool hasMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+		VkMemoryPropertyFlags getMemoryTypeProperties(uint32_t memoryTypeIndex) const {
+			return memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+		}
+
+		// linear is true for buffers and linear-tiled images, false for optimal-tiled images
+		VulkanAllocation allocate(
+			const VkMemoryRequirements& requirements,
+			VkMemoryPropertyFlags properties,
+			bool linear,
+			VulkanMemoryCategory category = VulkanMemoryCategory::Other);
+		VulkanAllocation allocate(
+			const VkMemoryRequirements& requirements,
+			VulkanMemoryUsage usage,
+			bool linear,
+			VulkanMemoryCategory category = VulkanMemoryCategory::Other);
+		void free(VulkanAllocation& allocation);
+
+		/* Defragmentation: finds room for an allocation's contents in a different, fuller block of
+			the same memory type so its current block can drain. Never creates a block; returns false
+			when nothing fits. The caller copies the data and frees current afterwards. */
+		bool reallocate(const VulkanAllocation& current, const VkMemoryRequirements& requirements, VulkanAllocation& moved);
+		// Cheap pre-check for reallocate that ignores alignment
+		bool canReallocate(const VulkanAllocation& current) const;
+		// How full an allocation's block is, 0..1
+		float blockUtilization(const VulkanAllocation& allocation) const;
+		// Frees the empty blocks kept around to absorb allocation churn
+		void releaseEmptyBlocks();
+
+		// Fills in everything but the budget fields, which only the device can query
+		VulkanMemoryStats getStats() const;
+
+		// Checks every block's free list against its allocations; meant for debugging and tests.
+		bool validate() const;
+		/* Drives a synthetic (null device) allocator through alignment, bufferImageGranularity,
+			non-coherent, dedicated, fragmentation and random churn cases, checking validate() after
+			every step. Reports failures to out; run with --allocator-selftest. */
+		static bool runSelfTest(std::ostream& out);
+
+		bool isSynthetic() const { return device == VK_NULL_HANDLE; }
+		size_t blockCount() const;
+		const VkPhysicalDeviceMemoryProperties& getMemoryProperties() const { return memoryProperties; }
+
+	private:
+		VkDeviceSize blockSizeForType(uint32_t memoryTypeIndex) const;
+		VulkanAllocation allocateFromType(
+			uint32_t memoryTypeIndex,
+			const VkMemoryRequirements& requirements,
+			bool linear,
+			VulkanMemoryCategory category);
+		VulkanMemoryBlock* createBlock(uint32_t memoryTypeIndex, VkDeviceSize size, bool dedicated);
+		void destroyBlock(VulkanMemoryBlock* block);
+		bool allocateFromBlock(
+			VulkanMemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment, VulkanAllocation& allocation);
+
+		VkDevice device;
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		VkDeviceSize bufferImageGranularity;
+		VkDeviceSize nonCoherentAtomSize;
+		VkDeviceSize preferredBlockSize;
+
+		std::vector<std::vector<std::unique_ptr<VulkanMemoryBlock>>> blocks; // indexed by memory type
+		std::array<VulkanMemoryStats::Usage, static_cast<size_t>(VulkanMemoryCategory::Count)> categoryUsage{};
+		uint64_t nextSyntheticHandle = 1;
+		mutable std::mutex mutex;
+	};
+}
@@ -0,0 +1,237 @@
+#include "VulkanMemoryAllocator.h"
+
+// std
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+namespace VulkanEngine {
+	namespace {
+		constexpr VkDeviceSize KiB = 1024;
+		constexpr VkDeviceSize MiB = 1024 * KiB;
+
+		constexpr VkDeviceSize TEST_BLOCK_SIZE = 1 * MiB;
+		constexpr VkDeviceSize TEST_GRANULARITY = 4 * KiB;
+		constexpr VkDeviceSize TEST_ATOM_SIZE = 256;
+
+		// Made-up memory types: 0 device local, 1 host coherent, 2 host cached but not coherent
+		constexpr uint32_t DEVICE_TYPE = 0;
+		constexpr uint32_t HOST_COHERENT_TYPE = 1;
+		constexpr uint32_t HOST_CACHED_TYPE = 2;
+
+		VkPhysicalDeviceMemoryProperties testMemoryProperties() {
+			VkPhysicalDeviceMemoryProperties properties{};
+			properties.memoryHeapCount = 2;
+			properties.memoryHeaps[0].size = 8192 * MiB;
+			properties.memoryHeaps[1].size = 256 * MiB;
+			properties.memoryTypeCount = 3;
+			properties.memoryTypes[DEVICE_TYPE] = { VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0 };
+			properties.memoryTypes[HOST_COHERENT_TYPE] =
+				{ VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 1 };
+			properties.memoryTypes[HOST_CACHED_TYPE] =
+				{ VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, 1 };
+			return properties;
+		}
+
+		VkMemoryRequirements requirements(VkDeviceSize size, VkDeviceSize alignment, uint32_t memoryType) {
+			VkMemoryRequirements memRequirements{};
+			memRequirements.size = size;
+			memRequirements.alignment = alignment;
+			memRequirements.memoryTypeBits = 1u << memoryType;
+			return memRequirements;
+		}
+
+		struct Live {
+			VulkanAllocation allocation;
+			bool linear;
+		};
+
+		// Live allocations must not overlap, and linear and optimal ones must not share a granularity page
+		bool checkNeighbours(const std::vector<Live>& live) {
+			for (size_t i = 0; i < live.size(); i++) {
+				for (size_t j = i + 1; j < live.size(); j++) {
+					const VulkanAllocation& a = live[i].allocation;
+					const VulkanAllocation& b = live[j].allocation;
+					if (a.block != b.block) continue;
+					if (a.offset < b.offset + b.size && b.offset < a.offset + a.size) return false;
+					if (live[i].linear == live[j].linear) continue;
+					VkDeviceSize aFirstPage = a.offset / TEST_GRANULARITY;
+					VkDeviceSize aLastPage = (a.offset + a.size - 1) / TEST_GRANULARITY;
+					VkDeviceSize bFirstPage = b.offset / TEST_GRANULARITY;
+					VkDeviceSize bLastPage = (b.offset + b.size - 1) / TEST_GRANULARITY;
+					if (aFirstPage <= bLastPage && bFirstPage <= aLastPage) return false;
+				}
+			}
+			return true;
+		}
+	}
+
+	bool VulkanMemoryAllocator::runSelfTest(std::ostream& out)
+	{
+		VkPhysicalDeviceLimits limits{};
+		limits.bufferImageGranularity = TEST_GRANULARITY;
+		limits.nonCoherentAtomSize = TEST_ATOM_SIZE;
+		VulkanMemoryAllocator allocator{ VK_NULL_HANDLE, testMemoryProperties(), limits, TEST_BLOCK_SIZE };
+
+		int failures = 0;
+		auto check = [&](bool condition, const std::string& what) {
+			if (!condition) {
+				out << "allocator self-test: FAILED " << what << "\n";
+				failures++;
+			}
+		};
+		auto validate = [&](const std::string& step) {
+			check(allocator.validate(), "validate() after " + step);
+		};
+
+		std::vector<Live> live;
+		auto allocate = [&](VkDeviceSize size, VkDeviceSize alignment, uint32_t memoryType, bool linear) {
+			live.push_back({ allocator.allocate(requirements(size, alignment, memoryType), 0, linear), linear });
+			return live.back().allocation;
+		};
+		auto freeAll = [&]() {
+			for (Live& entry : live) {
+				allocator.free(entry.allocation);
+			}
+			live.clear();
+		};
+
+		// alignment: odd sizes with growing alignments all land on aligned, disjoint offsets
+		for (VkDeviceSize alignment = 1; alignment <= 4 * KiB; alignment *= 4) {
+			VulkanAllocation allocation = allocate(alignment * 3 + 7, alignment, DEVICE_TYPE, true);
+			check(allocation.offset % alignment == 0, "alignment " + std::to_string(alignment));
+			validate("aligned allocation");
+		}
+		check(checkNeighbours(live), "aligned allocations overlap");
+		freeAll();
+		validate("freeing aligned allocations");
+
+		// bufferImageGranularity: interleaved buffers and optimal images never share a page
+		for (int i = 0; i < 32; i++) {
+			bool linear = i % 3 != 0;
+			VulkanAllocation allocation = allocate(linear ? 1000 : 3000, linear ? 16 : 512, DEVICE_TYPE, linear);
+			if (!linear) {
+				check(allocation.offset % TEST_GRANULARITY == 0 && allocation.size % TEST_GRANULARITY == 0,
+					"optimal allocation not padded to bufferImageGranularity");
+			}
+			validate("linear/optimal allocation");
+		}
+		check(checkNeighbours(live), "linear and optimal allocations share a granularity page");
+		// holes left by freed buffers must not take images without the padding
+		for (size_t i = 1; i < live.size(); i += 2) {
+			allocator.free(live[i].allocation);
+		}
+		live.erase(std::remove_if(live.begin(), live.end(),
+			[](const Live& entry) { return entry.allocation.block == nullptr; }), live.end());
+		validate("freeing every other linear/optimal allocation");
+		for (int i = 0; i < 16; i++) {
+			allocate(i % 2 ? 700 : 2000, 64, DEVICE_TYPE, i % 2 != 0);
+			validate("refilling linear/optimal holes");
+		}
+		check(checkNeighbours(live), "refilled holes share a granularity page");
+		freeAll();
+		validate("freeing linear/optimal allocations");
+
+		// non-coherent memory: ranges padded to nonCoherentAtomSize so flushes can't overlap
+		for (int i = 0; i < 8; i++) {
+			VulkanAllocation allocation = allocate(100, 4, HOST_CACHED_TYPE, true);
+			check(allocation.offset % TEST_ATOM_SIZE == 0 && allocation.size % TEST_ATOM_SIZE == 0,
+				"non-coherent allocation not padded to nonCoherentAtomSize");
+			validate("non-coherent allocation");
+		}
+		check(checkNeighbours(live), "non-coherent allocations overlap");
+		freeAll();
+		validate("freeing non-coherent allocations");
+		allocator.releaseEmptyBlocks();
+		check(allocator.blockCount() == 0, "releaseEmptyBlocks left blocks behind");
+
+		// dedicated blocks: anything over half a block gets its own, which goes away with it
+		{
+			size_t blocksBefore = allocator.blockCount();
+			VulkanAllocation allocation = allocate(TEST_BLOCK_SIZE * 3 / 4, 256, HOST_COHERENT_TYPE, true);
+			check(allocation.block != nullptr && allocation.block->dedicated && allocation.offset == 0,
+				"large allocation is not dedicated");
+			check(allocator.blockCount() == blocksBefore + 1, "dedicated allocation didn't add one block");
+			validate("dedicated allocation");
+			VulkanAllocation small = allocate(4 * KiB, 256, HOST_COHERENT_TYPE, true);
+			check(small.block != allocation.block, "small allocation placed in a dedicated block");
+			freeAll();
+			validate("freeing dedicated allocation");
+			check(allocator.blockCount() == blocksBefore + 1, "dedicated block outlived its allocation");
+		}
+		allocator.releaseEmptyBlocks();
+
+		// fragmentation and coalescing: fill one block, punch holes, then merge them back
+		{
+			const VkDeviceSize slot = TEST_BLOCK_SIZE / 16;
+			for (int i = 0; i < 16; i++) {
+				allocate(slot, 256, DEVICE_TYPE, true);
+			}
+			VulkanMemoryBlock* block = live[0].allocation.block;
+			bool oneBlock = std::all_of(live.begin(), live.end(),
+				[block](const Live& entry) { return entry.allocation.block == block; });
+			check(oneBlock && block->freeRanges.empty(), "16 slots didn't fill exactly one block");
+
+			for (size_t i = 1; i < live.size(); i += 2) {
+				allocator.free(live[i].allocation);
+				validate("punching a hole");
+			}
+			check(block->freeRanges.size() == 8, "holes were merged across live allocations");
+
+			VulkanAllocation wide = allocator.allocate(requirements(slot * 2, 256, DEVICE_TYPE), 0, true);
+			check(wide.block != block, "allocation larger than every hole was placed in the fragmented block");
+			VulkanAllocation narrow = allocator.allocate(requirements(slot, 256, DEVICE_TYPE), 0, true);
+			check(narrow.block == block, "allocation that fits a hole opened a new block");
+			allocator.free(wide);
+			allocator.free(narrow);
+			validate("filling a hole");
+
+			for (size_t i = 2; i < live.size(); i += 2) {
+				allocator.free(live[i].allocation);
+				validate("freeing between holes");
+			}
+			check(block->freeRanges.size() == 1 && block->freeRanges.begin()->first == slot &&
+				block->freeRanges.begin()->second == TEST_BLOCK_SIZE - slot,
+				"freed neighbours were not coalesced");
+			freeAll();
+			validate("emptying the fragmented block");
+		}
+		allocator.releaseEmptyBlocks();
+
+		// churn: random sizes, alignments, types and tiling, freed in random order
+		{
+			uint32_t seed = 12345;
+			auto next = [&seed]() {
+				seed = seed * 1664525u + 1013904223u; // LCG, so every run sees the same sequence
+				return seed >> 8;
+			};
+			for (int step = 0; step < 2000; step++) {
+				if (live.empty() || next() % 3 != 0) {
+					VkDeviceSize size = 1 + next() % (64 * KiB);
+					VkDeviceSize alignment = VkDeviceSize{ 1 } << (next() % 13);
+					allocate(size, alignment, next() % 3, next() % 2 == 0);
+				}
+				else {
+					size_t index = next() % live.size();
+					allocator.free(live[index].allocation);
+					live.erase(live.begin() + index);
+				}
+				validate("churn step " + std::to_string(step));
+				if (failures > 0) break;
+			}
+			check(checkNeighbours(live), "churn left overlapping allocations");
+			freeAll();
+			validate("freeing churn allocations");
+		}
+
+		VulkanMemoryStats stats = allocator.getStats();
+		for (auto& category : stats.categories) {
+			check(category.bytes == 0 && category.allocationCount == 0, "category usage not back to zero");
+		}
+		allocator.releaseEmptyBlocks();
+		check(allocator.blockCount() == 0, "blocks left after freeing everything");
+
+		out << "allocator self-test: " << (failures == 0 ? "passed" : std::to_string(failures) + " failures") << "\n";
+		return failures == 0;
+	}
+}
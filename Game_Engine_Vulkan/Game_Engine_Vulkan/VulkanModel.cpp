@@ -1,4 +1,5 @@
 #include "VulkanModel.h"
+#include "VulkanGeometryPool.h"
 #include "VulkanUtility.h"
 #include "Equations.h"
 #include "print_utility.h"
@@ -27,26 +28,31 @@ namespace std {
 }
 
 namespace VulkanEngine {
-	VulkanModel::VulkanModel(VulkanDevice& device, const VulkanModel::Builder& builder) : vulkanDevice{ device }
+	VulkanModel::VulkanModel(VulkanGeometryPool& geometryPool, const VulkanModel::Builder& builder,
+		VulkanUploadBatch* uploadBatch)
+		: geometryPool{ geometryPool }
 	{
-		createVertexBuffers(builder.vertices);
-		createIndexBuffers(builder.indices);
+		geometryHandle = geometryPool.allocate(builder.vertices, builder.indices, uploadBatch);
 	}
 
-	VulkanModel::~VulkanModel() {}
+	VulkanModel::~VulkanModel()
+	{
+		geometryPool.free(geometryHandle);
+	}
 
-	std::unique_ptr<VulkanModel> VulkanModel::createModelFromFile(VulkanDevice& device, const std::string& filepath)
+	std::unique_ptr<VulkanModel> VulkanModel::createModelFromFile(VulkanGeometryPool& geometryPool, const std::string& filepath,
+		VulkanUploadBatch* uploadBatch)
 	{
 		Builder builder{};
 		builder.loadModel(filepath);
 		std::cout << "Model's Vertex count: " << builder.vertices.size() << "\n";
 		std::cout << "Model's Index count: " << builder.indices.size() << "\n";
-		return std::make_unique<VulkanModel>(device, builder);
+		return std::make_unique<VulkanModel>(geometryPool, builder, uploadBatch);
 	}
 
-	std::unique_ptr<VulkanModel> VulkanModel::createModelFromEquation(VulkanDevice& device, 
+	std::unique_ptr<VulkanModel> VulkanModel::createModelFromEquation(VulkanGeometryPool& geometryPool, 
 		uint8_t eqn_num, glm::vec3 coefficients, int lower_x, int upper_x, int lower_y, int upper_y, float interval_density,
-		glm::vec3 color, std::vector<Vertex>& retriever_of_vertices)
+		glm::vec3 color, std::vector<Vertex>& retriever_of_vertices, VulkanUploadBatch* uploadBatch)
 	{
 		Builder builder{};
 		/*  IMPORTANT: Keep in mind to show 10 intervals, 11 vertices are needed,
@@ -56,97 +62,28 @@ namespace VulkanEngine {
 			lower_y * interval_density, (upper_y + 1) * interval_density, interval_density, color);
 		std::cout << "Graph's Vertex count: " << builder.vertices.size() << "\n";
 		std::cout << "Graph's Index count: " << builder.indices.size() << "\n";
-		return std::make_unique<VulkanModel>(device, builder);
+		return std::make_unique<VulkanModel>(geometryPool, builder, uploadBatch);
 	}
 
-	std::unique_ptr<VulkanModel> VulkanModel::createNormalForModel(VulkanDevice& device, std::vector<Vertex> model_vertices)
+	std::unique_ptr<VulkanModel> VulkanModel::createNormalForModel(VulkanGeometryPool& geometryPool, std::vector<Vertex> model_vertices,
+		VulkanUploadBatch* uploadBatch)
 	{
 		Builder builder{};
 		builder.visualizeNormal(model_vertices);
 		std::cout << "Normal Visualizer's Vertex count: " << builder.vertices.size() << "\n";
 		std::cout << "Normal Visualizer's Index count: " << builder.indices.size() << "\n";
-		return std::make_unique<VulkanModel>(device, builder);
+		return std::make_unique<VulkanModel>(geometryPool, builder, uploadBatch);
 	}
 
-	void VulkanModel::bind(VkCommandBuffer commandBuffer)
+	void VulkanModel::draw(VkCommandBuffer commandBuffer, VulkanCommandStats* stats)
 	{
-		VkBuffer buffers[] = { vertexBuffer->getBuffer() };
-		VkDeviceSize offsets[] = { 0 };
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
-
-		if (hasIndexBuffer) {
-			vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
-		}
-	}
-
-	void VulkanModel::draw(VkCommandBuffer commandBuffer)
-	{
-		if (hasIndexBuffer) {
-			vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+		const VulkanGeometryPool::Range& range = geometryPool.getRange(geometryHandle);
+		if (range.indexCount > 0) {
+			VulkanCommands::drawIndexed(
+				stats, commandBuffer, range.indexCount, 1, range.firstIndex, static_cast<int32_t>(range.firstVertex), 0);
 		} else {
-			vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
-		}
-	}
-
-	void VulkanModel::createVertexBuffers(const std::vector<Vertex>& vertices)
-	{
-		vertexCount = static_cast<uint32_t>(vertices.size());
-		assert(vertexCount >= 3 && "Vertex count must be at least 3");
-		VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-		uint32_t vertexSize = sizeof(vertices[0]);
-
-		VulkanBuffer stagingBuffer{
-			vulkanDevice,
-			vertexSize,
-			vertexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		};
-
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*)vertices.data());
-
-		vertexBuffer = std::make_unique<VulkanBuffer>(
-			vulkanDevice,
-			vertexSize,
-			vertexCount,
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-		);
-
-		vulkanDevice.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
-	}
-	void VulkanModel::createIndexBuffers(const std::vector<uint32_t>& indices)
-	{
-		indexCount = static_cast<uint32_t>(indices.size());
-		hasIndexBuffer = indexCount > 0;
-		if (!hasIndexBuffer) {
-			return;
+			VulkanCommands::draw(stats, commandBuffer, range.vertexCount, 1, range.firstVertex, 0);
 		}
-
-		VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
-		uint32_t indexSize = sizeof(indices[0]);
-
-		VulkanBuffer stagingBuffer{
-			vulkanDevice,
-			indexSize,
-			indexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		};
-
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*)indices.data());
-
-		indexBuffer = std::make_unique<VulkanBuffer>(
-			vulkanDevice,
-			indexSize,
-			indexCount,
-			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-			);
-
-		vulkanDevice.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
 	}
 
 	std::vector<VkVertexInputBindingDescription> VulkanModel::Vertex::getBindingDescriptions()
@@ -2,6 +2,7 @@
 
 #include "VulkanDevice.h"
 #include "VulkanBuffer.h"
+#include "VulkanCommandStats.h"
 // libs
 #define GLM_FORCE_RADIAN
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -11,6 +12,9 @@
 #include <vector>
 
 namespace VulkanEngine {
+	class VulkanGeometryPool;
+	class VulkanUploadBatch;
+
 	class VulkanModel {
 	public:
 		struct Vertex {
@@ -35,29 +39,26 @@ namespace VulkanEngine {
 			void visualizeNormal(std::vector<Vertex> model_vertices);
 		};
 
-		VulkanModel(VulkanDevice& device, const VulkanModel::Builder& builder);
+		// Without an uploadBatch the data goes through the device uploader's pending batch
+		VulkanModel(VulkanGeometryPool& geometryPool, const VulkanModel::Builder& builder,
+			VulkanUploadBatch* uploadBatch = nullptr);
 		~VulkanModel();
 
 		VulkanModel(const VulkanModel&) = delete; // deleting copy constructors
 		VulkanModel& operator=(const VulkanModel&) = delete;
 
-		static std::unique_ptr<VulkanModel> createModelFromFile(VulkanDevice& device, const std::string& filepath);
-		static std::unique_ptr<VulkanModel> createModelFromEquation(VulkanDevice& device, uint8_t eqn_num,
+		static std::unique_ptr<VulkanModel> createModelFromFile(VulkanGeometryPool& geometryPool, const std::string& filepath,
+			VulkanUploadBatch* uploadBatch = nullptr);
+		static std::unique_ptr<VulkanModel> createModelFromEquation(VulkanGeometryPool& geometryPool, uint8_t eqn_num,
 			glm::vec3 coefficients, int lower_x, int upper_x, int lower_y, int upper_y, float interval_size,
-			glm::vec3 color, std::vector<Vertex>& retriever_of_vertices);
-		static std::unique_ptr<VulkanModel> createNormalForModel(VulkanDevice& device, std::vector<Vertex> model_vertices);
+			glm::vec3 color, std::vector<Vertex>& retriever_of_vertices, VulkanUploadBatch* uploadBatch = nullptr);
+		static std::unique_ptr<VulkanModel> createNormalForModel(VulkanGeometryPool& geometryPool, std::vector<Vertex> model_vertices,
+			VulkanUploadBatch* uploadBatch = nullptr);
 
-		void bind(VkCommandBuffer commandBuffer);
-		void draw(VkCommandBuffer commandBuffer);
+		// The pool's buffers must already be bound (VulkanGeometryPool::bind)
+		void draw(VkCommandBuffer commandBuffer, VulkanCommandStats* stats = nullptr);
 	private:
-		void createVertexBuffers(const std::vector<Vertex>& vertices);
-		void createIndexBuffers(const std::vector<uint32_t>& indices);
-		VulkanDevice& vulkanDevice;
-		std::unique_ptr<VulkanBuffer> vertexBuffer;
-		uint32_t vertexCount;
-
-		bool hasIndexBuffer = false;
-		std::unique_ptr<VulkanBuffer> indexBuffer;
-		uint32_t indexCount;
+		VulkanGeometryPool& geometryPool;
+		uint32_t geometryHandle; // VulkanGeometryPool::Handle
 	};
 }
\ No newline at end of file
@@ -38,9 +38,9 @@ namespace VulkanEngine {
 		return buffer;
 	}
 
-	void VulkanPipeline::bind(VkCommandBuffer commandBuffer)
+	void VulkanPipeline::bind(VkCommandBuffer commandBuffer, VulkanCommandStats* stats)
 	{
-		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+		VulkanCommands::bindPipeline(stats, commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
 	}
 
 	void VulkanPipeline::defaultPipelineConfigInfo(PipelineConfigInfo& configInfo)
@@ -178,7 +178,7 @@ namespace VulkanEngine {
 		pipelineInfo.basePipelineIndex = -1;
 		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-		if (vkCreateGraphicsPipelines(vulkanDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+		if (vkCreateGraphicsPipelines(vulkanDevice.device(), vulkanDevice.pipelineCache(), 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create graphics pipeline");
 		}
 	}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "VulkanDevice.h"
+#include "VulkanCommandStats.h"
 
 #include <string>
 #include <vector>
@@ -38,7 +39,8 @@ namespace VulkanEngine {
 		VulkanPipeline() = default;
 		VulkanPipeline& operator=(const VulkanPipeline&) = delete;
 
-		void bind(VkCommandBuffer commandBuffer);
+		void bind(VkCommandBuffer commandBuffer, VulkanCommandStats* stats = nullptr);
+		VkPipeline getPipeline() const { return graphicsPipeline; }
 		static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
 		static void enableAlphaBlending(PipelineConfigInfo& configInfo);
 	private:
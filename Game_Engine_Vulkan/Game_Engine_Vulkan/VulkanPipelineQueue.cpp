@@ -0,0 +1,23 @@
+#include "VulkanPipelineQueue.h"
+#include "Tracer.h"
+
+namespace VulkanEngine {
+	VulkanPipelineQueue::VulkanPipelineQueue(VulkanDevice& device, VulkanThreadPool& threadPool)
+		: vulkanDevice{ device }, threadPool{ threadPool }
+	{
+	}
+
+	PipelineHandle VulkanPipelineQueue::submit(
+		const std::string& vertFilepath,
+		const std::string& fragFilepath,
+		std::unique_ptr<PipelineConfigInfo> configInfo)
+	{
+		// shared, not unique: some std::packaged_task implementations need a copyable task
+		std::shared_ptr<PipelineConfigInfo> config{ std::move(configInfo) };
+		VulkanDevice& device = vulkanDevice;
+		return PipelineHandle{ threadPool.submit([&device, vertFilepath, fragFilepath, config] {
+			TraceZone zone{ "CreatePipeline" };
+			return std::make_unique<VulkanPipeline>(device, vertFilepath, fragFilepath, *config);
+		}).share() };
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "VulkanPipeline.h"
+#include "VulkanThreadPool.h"
+
+// std
+#include <cassert>
+#include <future>
+#include <memory>
+#include <string>
+
+namespace VulkanEngine {
+	/* A pipeline compiling on a VulkanPipelineQueue. The first use blocks until it is ready and
+		rethrows a failed compile; any number of threads may use it at once. Destroying or
+		reassigning the handle waits for the compile too, so it never outlives its inputs. */
+	class PipelineHandle {
+	public:
+		PipelineHandle() = default;
+		explicit PipelineHandle(std::shared_future<std::unique_ptr<VulkanPipeline>> pending)
+			: pending{ std::move(pending) } {}
+		~PipelineHandle() { wait(); }
+
+		PipelineHandle(PipelineHandle&&) = default;
+		PipelineHandle& operator=(PipelineHandle&& other) {
+			wait();
+			pending = std::move(other.pending);
+			return *this;
+		}
+
+		VulkanPipeline& get() const {
+			assert(pending.valid() && "Pipeline was never queued");
+			return *pending.get();
+		}
+		VulkanPipeline* operator->() const { return &get(); }
+
+		// Blocks until the compile has finished, without rethrowing its failure
+		void wait() const {
+			if (pending.valid()) {
+				pending.wait();
+			}
+		}
+
+	private:
+		std::shared_future<std::unique_ptr<VulkanPipeline>> pending;
+	};
+
+	/* Compiles pipelines on a thread pool, so systems built one after another at startup don't pay
+		for each other's shader compiles. vkCreateGraphicsPipelines and the device's pipeline cache
+		are both safe to use from several threads at once. */
+	class VulkanPipelineQueue {
+	public:
+		VulkanPipelineQueue(VulkanDevice& device, VulkanThreadPool& threadPool);
+
+		VulkanPipelineQueue(const VulkanPipelineQueue&) = delete;
+		VulkanPipelineQueue& operator=(const VulkanPipelineQueue&) = delete;
+
+		/* The config is handed over because it points into itself and has to live until the worker
+			is done with it. Everything else it references (layout, render pass) must outlive the
+			returned handle. */
+		PipelineHandle submit(
+			const std::string& vertFilepath,
+			const std::string& fragFilepath,
+			std::unique_ptr<PipelineConfigInfo> configInfo);
+
+	private:
+		VulkanDevice& vulkanDevice;
+		VulkanThreadPool& threadPool;
+	};
+}
@@ -0,0 +1,9 @@
+#include "VulkanRenderSystem.h"
+
+namespace VulkanEngine {
+	VulkanRenderSystem::~VulkanRenderSystem()
+	{
+		vulkanPipeline.wait();
+		vkDestroyPipelineLayout(vulkanDevice.device(), pipelineLayout, nullptr);
+	}
+}
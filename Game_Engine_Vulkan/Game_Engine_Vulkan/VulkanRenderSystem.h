@@ -0,0 +1,22 @@
+#pragma once
+
+#include "VulkanDevice.h"
+#include "VulkanPipelineQueue.h"
+
+namespace VulkanEngine {
+	/* What the render systems share: a pipeline layout and the pipeline queued with it. The layout
+		is destroyed here, after any compile still reading it has finished. */
+	class VulkanRenderSystem {
+	public:
+		VulkanRenderSystem(const VulkanRenderSystem&) = delete;
+		VulkanRenderSystem& operator=(const VulkanRenderSystem&) = delete;
+
+	protected:
+		explicit VulkanRenderSystem(VulkanDevice& device) : vulkanDevice{ device } {}
+		~VulkanRenderSystem();
+
+		VulkanDevice& vulkanDevice;
+		VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+		PipelineHandle vulkanPipeline;
+	};
+}
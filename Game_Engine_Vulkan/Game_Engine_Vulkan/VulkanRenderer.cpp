@@ -1,5 +1,6 @@
 #include "VulkanRenderer.h"
 #include "VulkanGameObject.h"
+#include "Tracer.h"
 
 #include <iostream>
 #include <stdexcept>
@@ -7,22 +8,45 @@
 
 namespace VulkanEngine {
 
-	VulkanRenderer::VulkanRenderer(VulkanWindow& window, VulkanDevice& device) 
-		: vulkanWindow{ window }, vulkanDevice{ device } 
+	VulkanRenderer::VulkanRenderer(
+		VulkanWindow& window,
+		VulkanDevice& device,
+		uint32_t requestedFramesInFlight,
+		uint32_t minImageCount,
+		VkPresentModeKHR presentMode)
+		: vulkanWindow{ window },
+		vulkanDevice{ device },
+		framesInFlight{ std::max(requestedFramesInFlight, 1u) },
+		minImageCount{ minImageCount },
+		presentMode{ presentMode }
 	{
 		recreateSwapChain();
 		createCommandBuffers();
+		secondaryRecorders.resize(framesInFlight);
+		frameAllocator = std::make_unique<VulkanFrameAllocator>(
+			vulkanDevice, FRAME_ALLOCATOR_SIZE, framesInFlight);
 	}
 
 	VulkanRenderer::~VulkanRenderer() {
+		vkDestroyCommandPool(vulkanDevice.device(), cachedCommandPool, nullptr);
+		destroySecondaryRecorders();
 		freeCommandBuffers();
 	}
 
 	VkCommandBuffer VulkanRenderer::beginFrame()
 	{
 		assert(!isFrameStarted && "Can't call beginFrame while already in progress");
+		releaseRetiredSwapChains();
+		if (presentModeChanged) {
+			presentModeChanged = false;
+			recreateSwapChain();
+		}
 
-		auto result = vulkanSwapChain->acquireNextImage(&currentImageIndex);
+		VkResult result;
+		{
+			TraceZone zone{ "Acquire" };
+			result = vulkanSwapChain->acquireNextImage(&currentImageIndex);
+		}
 		if (result == VK_ERROR_OUT_OF_DATE_KHR) {
 			recreateSwapChain();
 			return nullptr;
@@ -33,10 +57,20 @@ namespace VulkanEngine {
 		}
 
 		isFrameStarted = true;
+		// acquireNextImage waited on this frame's fence, so its transient data is no longer read
+		frameAllocator->reset(currentFrameIndex);
+		vkResetCommandPool(vulkanDevice.device(), commandPools[currentFrameIndex], 0);
+		for (auto& recorder : secondaryRecorders[currentFrameIndex]) {
+			if (recorder.usedCount > 0) {
+				vkResetCommandPool(vulkanDevice.device(), recorder.commandPool, 0);
+				recorder.usedCount = 0;
+			}
+		}
 
 		auto commandBuffer = getCurrentCommandBuffer();
 		VkCommandBufferBeginInfo beginInfo{};
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
 		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
 			throw std::runtime_error("failed to begin recording command buffer!");
@@ -53,7 +87,10 @@ namespace VulkanEngine {
 			throw std::runtime_error("failed to record command buffer!");
 		}
 
-		auto result = vulkanSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+		VkSemaphore uploadSemaphore =
+			uploadWaitValue > 0 ? vulkanDevice.uploader().getTimelineSemaphore() : VK_NULL_HANDLE;
+		auto result = vulkanSwapChain->submitCommandBuffers(
+			&commandBuffer, &currentImageIndex, uploadSemaphore, uploadWaitValue);
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ||
 			vulkanWindow.wasWindowResized()) {
 			vulkanWindow.resetWindowResizedFlag();
@@ -64,10 +101,18 @@ namespace VulkanEngine {
 		}
 
 		isFrameStarted = false;
-		currentFrameIndex = (currentFrameIndex + 1) % VulkanSwapChain::MAX_FRAMES_IN_FLIGHT;
+		currentFrameIndex = (currentFrameIndex + 1) % framesInFlight;
+	}
+
+	void VulkanRenderer::setPresentMode(VkPresentModeKHR mode)
+	{
+		if (mode != presentMode) {
+			presentMode = mode;
+			presentModeChanged = true;
+		}
 	}
 
-	void VulkanRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer)
+	void VulkanRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents)
 	{
 		assert(isFrameStarted && "Can't call beginSwapChainRenderPass if frame is not in progress");
 		assert(
@@ -88,8 +133,16 @@ namespace VulkanEngine {
 		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		renderPassInfo.pClearValues = clearValues.data();
 
-		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+
+		// secondary command buffers don't inherit dynamic state and set their own
+		if (contents == VK_SUBPASS_CONTENTS_INLINE) {
+			recordViewportAndScissor(commandBuffer);
+		}
+	}
 
+	void VulkanRenderer::recordViewportAndScissor(VkCommandBuffer commandBuffer)
+	{
 		VkViewport viewport{};
 		viewport.x = 0.0f;
 		viewport.y = 0.0f;
@@ -111,29 +164,234 @@ namespace VulkanEngine {
 		vkCmdEndRenderPass(commandBuffer);
 	}
 
+	void VulkanRenderer::setRecordingSlotCount(uint32_t count)
+	{
+		assert(!isFrameStarted && "Can't change recording slots while frame is in progress");
+		if (count == recordingSlotCount) {
+			return;
+		}
+		// command buffers of earlier frames may still be executing
+		vkDeviceWaitIdle(vulkanDevice.device());
+		destroySecondaryRecorders();
+
+		QueueFamilyIndices queueFamilyIndices = vulkanDevice.findPhysicalQueueFamilies();
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		for (auto& frameRecorders : secondaryRecorders) {
+			frameRecorders.resize(count);
+			for (auto& recorder : frameRecorders) {
+				if (vkCreateCommandPool(vulkanDevice.device(), &poolInfo, nullptr, &recorder.commandPool) !=
+					VK_SUCCESS) {
+					throw std::runtime_error("failed to create secondary command pool!");
+				}
+			}
+		}
+		recordingSlotCount = count;
+	}
+
+	VkCommandBuffer VulkanRenderer::beginSecondaryCommandBuffer(uint32_t slot)
+	{
+		assert(isFrameStarted && "Can't begin secondary command buffer if frame is not in progress");
+		assert(slot < recordingSlotCount && "Recording slot out of range");
+
+		SecondaryRecorder& recorder = secondaryRecorders[currentFrameIndex][slot];
+		if (recorder.usedCount == recorder.commandBuffers.size()) {
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandPool = recorder.commandPool;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer;
+			if (vkAllocateCommandBuffers(vulkanDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+				throw std::runtime_error("failed to allocate secondary command buffer!");
+			}
+			recorder.commandBuffers.push_back(commandBuffer);
+		}
+		VkCommandBuffer commandBuffer = recorder.commandBuffers[recorder.usedCount++];
+
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = vulkanSwapChain->getRenderPass();
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = vulkanSwapChain->getFrameBuffer(currentImageIndex);
+		inheritanceInfo.pipelineStatistics = inheritedPipelineStatistics;
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags =
+			VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("failed to begin recording secondary command buffer!");
+		}
+		recordViewportAndScissor(commandBuffer);
+		return commandBuffer;
+	}
+
+	void VulkanRenderer::endSecondaryCommandBuffer(VkCommandBuffer commandBuffer)
+	{
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to record secondary command buffer!");
+		}
+	}
+
+	void VulkanRenderer::executeSecondaryCommandBuffers(
+		VkCommandBuffer commandBuffer, const std::vector<VkCommandBuffer>& secondaryCommandBuffers)
+	{
+		assert(
+			commandBuffer == getCurrentCommandBuffer() &&
+			"Can't execute secondary command buffers on command buffer from a different frame");
+		if (secondaryCommandBuffers.empty()) {
+			return;
+		}
+		vkCmdExecuteCommands(
+			commandBuffer,
+			static_cast<uint32_t>(secondaryCommandBuffers.size()),
+			secondaryCommandBuffers.data());
+	}
+
+	uint32_t VulkanRenderer::createCachedCommandBuffer()
+	{
+		if (cachedCommandPool == VK_NULL_HANDLE) {
+			QueueFamilyIndices queueFamilyIndices = vulkanDevice.findPhysicalQueueFamilies();
+			VkCommandPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
+			poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+			if (vkCreateCommandPool(vulkanDevice.device(), &poolInfo, nullptr, &cachedCommandPool) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create cached command pool!");
+			}
+		}
+
+		std::vector<CachedRecording> recordings(framesInFlight);
+		for (auto& recording : recordings) {
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandPool = cachedCommandPool;
+			allocInfo.commandBufferCount = 1;
+			if (vkAllocateCommandBuffers(vulkanDevice.device(), &allocInfo, &recording.commandBuffer) != VK_SUCCESS) {
+				throw std::runtime_error("failed to allocate cached command buffer!");
+			}
+		}
+		cachedRecordings.push_back(std::move(recordings));
+		return static_cast<uint32_t>(cachedRecordings.size() - 1);
+	}
+
+	bool VulkanRenderer::isCachedCommandBufferValid(uint32_t id, const RecordingKey& key) const
+	{
+		assert(isFrameStarted && "Can't check cached command buffer if frame is not in progress");
+		const CachedRecording& recording = cachedRecordings[id][currentFrameIndex];
+		return recording.valid && recording.key == key;
+	}
+
+	VkCommandBuffer VulkanRenderer::beginCachedCommandBuffer(uint32_t id, const RecordingKey& key)
+	{
+		assert(isFrameStarted && "Can't begin cached command buffer if frame is not in progress");
+		// only this frame's copy is re-recorded, and beginFrame already waited for its last submission
+		CachedRecording& recording = cachedRecordings[id][currentFrameIndex];
+		recording.key = key;
+		recording.valid = true;
+
+		// the framebuffer changes every frame, so it is left out of the inheritance info
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = vulkanSwapChain->getRenderPass();
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = VK_NULL_HANDLE;
+		inheritanceInfo.pipelineStatistics = inheritedPipelineStatistics;
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		if (vkBeginCommandBuffer(recording.commandBuffer, &beginInfo) != VK_SUCCESS) {
+			recording.valid = false;
+			throw std::runtime_error("failed to begin recording cached command buffer!");
+		}
+		recordViewportAndScissor(recording.commandBuffer);
+		return recording.commandBuffer;
+	}
+
+	VkCommandBuffer VulkanRenderer::getCachedCommandBuffer(uint32_t id) const
+	{
+		assert(isFrameStarted && "Can't get cached command buffer if frame is not in progress");
+		return cachedRecordings[id][currentFrameIndex].commandBuffer;
+	}
+
+	void VulkanRenderer::invalidateCachedCommandBuffers()
+	{
+		for (auto& recordings : cachedRecordings) {
+			for (auto& recording : recordings) {
+				recording.valid = false;
+			}
+		}
+	}
+
+	void VulkanRenderer::setInheritedPipelineStatistics(VkQueryPipelineStatisticFlags flags)
+	{
+		assert(!isFrameStarted && "Can't change inherited queries while frame is in progress");
+		if (flags != inheritedPipelineStatistics) {
+			inheritedPipelineStatistics = flags;
+			invalidateCachedCommandBuffers();
+		}
+	}
+
+	void VulkanRenderer::destroySecondaryRecorders()
+	{
+		// destroying a pool frees its command buffers
+		for (auto& frameRecorders : secondaryRecorders) {
+			for (auto& recorder : frameRecorders) {
+				vkDestroyCommandPool(vulkanDevice.device(), recorder.commandPool, nullptr);
+			}
+			frameRecorders.clear();
+		}
+		recordingSlotCount = 0;
+	}
+
 	void VulkanRenderer::createCommandBuffers()
 	{
-		commandBuffers.resize(VulkanSwapChain::MAX_FRAMES_IN_FLIGHT);
+		commandPools.resize(framesInFlight);
+		commandBuffers.resize(framesInFlight);
+
+		// no RESET_COMMAND_BUFFER_BIT: each pool is reset as a whole once its frame's fence has signaled
+		QueueFamilyIndices queueFamilyIndices = vulkanDevice.findPhysicalQueueFamilies();
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		for (size_t i = 0; i < commandPools.size(); i++) {
+			if (vkCreateCommandPool(vulkanDevice.device(), &poolInfo, nullptr, &commandPools[i]) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create frame command pool!");
+			}
 
-		VkCommandBufferAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandPool = vulkanDevice.getCommandPool();
-		allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandPool = commandPools[i];
+			allocInfo.commandBufferCount = 1;
 
-		if (vkAllocateCommandBuffers(vulkanDevice.device(), &allocInfo, commandBuffers.data())
-			!= VK_SUCCESS) {
-			throw std::runtime_error("failed to allocate command buffers!");
+			if (vkAllocateCommandBuffers(vulkanDevice.device(), &allocInfo, &commandBuffers[i])
+				!= VK_SUCCESS) {
+				throw std::runtime_error("failed to allocate command buffers!");
+			}
 		}
 	}
 
 	void VulkanRenderer::freeCommandBuffers()
 	{
-		vkFreeCommandBuffers(
-			vulkanDevice.device(),
-			vulkanDevice.getCommandPool(),
-			static_cast<uint32_t>(commandBuffers.size()),
-			commandBuffers.data());
+		// destroying the pools frees their command buffers
+		for (auto commandPool : commandPools) {
+			vkDestroyCommandPool(vulkanDevice.device(), commandPool, nullptr);
+		}
+		commandPools.clear();
 		commandBuffers.clear();
 	}
 
@@ -144,18 +402,40 @@ namespace VulkanEngine {
 			extent = vulkanWindow.getExtent();
 			glfwWaitEvents();
 		}
-		vkDeviceWaitIdle(vulkanDevice.device());
-		vulkanSwapChain = nullptr;
+		// recordings reference the old render pass and extent; each is re-recorded when its frame comes round
+		invalidateCachedCommandBuffers();
 		if (vulkanSwapChain == nullptr) {
-			vulkanSwapChain = std::make_unique<VulkanSwapChain>(vulkanDevice, extent);
+			vulkanSwapChain = std::make_unique<VulkanSwapChain>(
+				vulkanDevice, extent, framesInFlight, minImageCount, presentMode);
 		}
 		else {
+			/* No device-wide wait: the old swapchain is handed over as oldSwapchain and kept alive
+				until the frames in flight that still use it have finished. The new one carries on its
+				frame timeline and frame index. */
 			std::shared_ptr<VulkanSwapChain> oldSwapChain = std::move(vulkanSwapChain);
-			vulkanSwapChain = std::make_unique<VulkanSwapChain>(vulkanDevice, extent, std::move(vulkanSwapChain));
+			vulkanSwapChain = std::make_unique<VulkanSwapChain>(vulkanDevice, extent, oldSwapChain, presentMode);
 
 			if (!oldSwapChain->compareSwapFormats(*vulkanSwapChain.get())) {
 				throw std::runtime_error("Swap chain image(or depth) format has changed!");
 			}
+			/* Frames submitted so far may still draw into its framebuffers. Present gives no completion
+				signal, so wait one frame more: once the next frame retires, the queue has also moved
+				past the presents that waited on the old swapchain's semaphores. */
+			retiredSwapChains.push_back({ std::move(oldSwapChain), vulkanSwapChain->getSubmittedFrameValue() + 1 });
+		}
+	}
+
+	void VulkanRenderer::releaseRetiredSwapChains()
+	{
+		if (retiredSwapChains.empty()) {
+			return;
 		}
+		uint64_t retiredValue = vulkanSwapChain->getCompletedFrameValue();
+		retiredSwapChains.erase(
+			std::remove_if(
+				retiredSwapChains.begin(),
+				retiredSwapChains.end(),
+				[retiredValue](const RetiredSwapChain& retired) { return retired.frameValue <= retiredValue; }),
+			retiredSwapChains.end());
 	}
 }
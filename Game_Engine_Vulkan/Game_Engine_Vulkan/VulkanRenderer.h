@@ -1,17 +1,26 @@
 #pragma once
 
 #include "VulkanDevice.h"
+#include "VulkanFrameAllocator.h"
 #include "VulkanSwapChain.h"
+#include "VulkanUtility.h"
 #include "VulkanWindow.h"
 // std
+#include <algorithm>
 #include <cassert>
 #include <memory>
 #include <vector>
 namespace VulkanEngine {
 	class VulkanRenderer {
 	public:
+		static constexpr VkDeviceSize FRAME_ALLOCATOR_SIZE = 4 * 1024 * 1024; // per frame in flight
 
-		VulkanRenderer(VulkanWindow& window, VulkanDevice& device);
+		VulkanRenderer(
+			VulkanWindow& window,
+			VulkanDevice& device,
+			uint32_t requestedFramesInFlight = VulkanSwapChain::DEFAULT_FRAMES_IN_FLIGHT,
+			uint32_t minImageCount = 0,
+			VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR);
 		~VulkanRenderer();
 
 		VulkanRenderer(const VulkanRenderer&) = delete; // deleting copy constructors
@@ -20,6 +29,12 @@ namespace VulkanEngine {
 		VkRenderPass getSwapChainRenderPass() const { return vulkanSwapChain->getRenderPass(); }
 		float getAspectRatio() const { return vulkanSwapChain->extentAspectRatio(); }
 		bool isFrameInProgress() const { return isFrameStarted; }
+		// Everything kept per frame in flight is sized from this
+		uint32_t getFramesInFlight() const { return framesInFlight; }
+		// Takes effect at the next beginFrame, which recreates the swapchain
+		void setPresentMode(VkPresentModeKHR mode);
+		VkPresentModeKHR getPresentMode() const { return vulkanSwapChain->getPresentMode(); }
+		VulkanFrameAllocator& getFrameAllocator() const { return *frameAllocator; }
 
 		VkCommandBuffer getCurrentCommandBuffer() const {
 			assert(isFrameStarted && "Cannot get command buffer when frame not in progress");
@@ -31,24 +46,96 @@ namespace VulkanEngine {
 			return currentFrameIndex;
 		}
 
+		// Timeline value the frame in progress signals once the GPU is done with it
+		uint64_t getFrameValue() const {
+			assert(isFrameStarted && "Cannot get frame value when frame not in progress");
+			return vulkanSwapChain->getSubmittedFrameValue() + 1;
+		}
+		bool isFrameRetired(uint64_t frameValue) const { return vulkanSwapChain->isFrameComplete(frameValue); }
+		uint64_t getRetiredFrameValue() const { return vulkanSwapChain->getCompletedFrameValue(); }
+
+		// Frames submitted from now on wait (on the GPU) for the upload to land
+		void waitForUpload(UploadTicket ticket) {
+			uploadWaitValue = std::max(uploadWaitValue, ticket.value);
+		}
+
 		VkCommandBuffer beginFrame();
 		void endFrame();
-		void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+		// With VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS the pass is filled by executeSecondaryCommandBuffers
+		void beginSwapChainRenderPass(
+			VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 		void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
+		/* Parallel recording: every slot has its own command pool per frame in flight, so each
+			thread records through a slot nobody else uses during the frame. Set the slot count
+			while no frame is in progress. */
+		void setRecordingSlotCount(uint32_t count);
+		uint32_t getRecordingSlotCount() const { return recordingSlotCount; }
+		// Secondary command buffer that continues the swapchain render pass, viewport and scissor already set
+		VkCommandBuffer beginSecondaryCommandBuffer(uint32_t slot);
+		void endSecondaryCommandBuffer(VkCommandBuffer commandBuffer);
+		void executeSecondaryCommandBuffers(
+			VkCommandBuffer commandBuffer, const std::vector<VkCommandBuffer>& secondaryCommandBuffers);
+
+		/* Cached recording: a secondary command buffer per frame in flight that is kept across frames
+			and only re-recorded when the caller's key changes or the swapchain is recreated. The key
+			must cover everything recorded into it, dynamic offsets included. */
+		uint32_t createCachedCommandBuffer();
+		bool isCachedCommandBufferValid(uint32_t id, const RecordingKey& key) const;
+		// Re-records this frame's copy; finish it with endSecondaryCommandBuffer
+		VkCommandBuffer beginCachedCommandBuffer(uint32_t id, const RecordingKey& key);
+		VkCommandBuffer getCachedCommandBuffer(uint32_t id) const;
+		void invalidateCachedCommandBuffers();
+
+		/* Pipeline statistics a query of the primary command buffer may count while secondary ones
+			run; needs the inheritedQueries feature. Cached recordings are re-recorded to match. */
+		void setInheritedPipelineStatistics(VkQueryPipelineStatisticFlags flags);
+
 	private:
+		struct SecondaryRecorder {
+			VkCommandPool commandPool = VK_NULL_HANDLE;
+			std::vector<VkCommandBuffer> commandBuffers;
+			size_t usedCount = 0;
+		};
+		// A replaced swapchain, kept until the frames that used its images and framebuffers are done
+		struct RetiredSwapChain {
+			std::shared_ptr<VulkanSwapChain> swapChain;
+			uint64_t frameValue;
+		};
+		struct CachedRecording {
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			RecordingKey key{};
+			bool valid = false;
+		};
+
 		// Renderer
 		void createCommandBuffers();
 		void freeCommandBuffers();
+		void destroySecondaryRecorders();
+		void recordViewportAndScissor(VkCommandBuffer commandBuffer);
 		void recreateSwapChain();
+		void releaseRetiredSwapChains();
 
 		VulkanWindow& vulkanWindow;
 		VulkanDevice& vulkanDevice;
+		uint32_t framesInFlight;
+		uint32_t minImageCount;
+		VkPresentModeKHR presentMode;
+		bool presentModeChanged = false;
 		std::unique_ptr<VulkanSwapChain> vulkanSwapChain;
+		std::vector<RetiredSwapChain> retiredSwapChains;
+		std::vector<VkCommandPool> commandPools; // one per frame in flight
 		std::vector<VkCommandBuffer> commandBuffers;
+		std::unique_ptr<VulkanFrameAllocator> frameAllocator;
+		std::vector<std::vector<SecondaryRecorder>> secondaryRecorders; // [frame in flight][slot]
+		uint32_t recordingSlotCount = 0;
+		VkCommandPool cachedCommandPool = VK_NULL_HANDLE; // buffers are re-recorded one by one
+		std::vector<std::vector<CachedRecording>> cachedRecordings; // [id][frame in flight]
+		VkQueryPipelineStatisticFlags inheritedPipelineStatistics = 0;
 
 		uint32_t currentImageIndex;
 		int currentFrameIndex = 0;
 		bool isFrameStarted = 0;
+		uint64_t uploadWaitValue = 0;
 	};
 }
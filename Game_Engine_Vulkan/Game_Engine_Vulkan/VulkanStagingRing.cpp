@@ -0,0 +1,97 @@
+#include "VulkanStagingRing.h"
+#include "VulkanBufferPool.h"
+
+// std
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace VulkanEngine {
+	VulkanStagingRing::VulkanStagingRing(VulkanDevice& device, VkDeviceSize capacity)
+		: vulkanDevice{ device }, capacity{ capacity }
+	{
+		vulkanDevice.createBuffer(
+			capacity,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VulkanMemoryUsage::Upload,
+			buffer,
+			allocation);
+		if (allocation.mapped == nullptr) {
+			throw std::runtime_error("failed to map staging ring!");
+		}
+		overflowPool = std::make_unique<VulkanBufferPool>(vulkanDevice);
+	}
+
+	VulkanStagingRing::~VulkanStagingRing()
+	{
+		overflowBuffers.clear();
+		overflowPool.reset();
+		vulkanDevice.destroyBuffer(buffer, allocation);
+	}
+
+	VulkanStagingRing::Region VulkanStagingRing::allocate(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		uint64_t position = (head + alignment - 1) / alignment * alignment;
+		if (position % capacity + size > capacity) {
+			// doesn't fit before the end of the buffer, skip to the start
+			position = (position / capacity + 1) * capacity;
+		}
+		if (size <= capacity && position + size - tail <= capacity) {
+			head = position + size;
+			VkDeviceSize offset = position % capacity;
+			return Region{ buffer, offset, static_cast<char*>(allocation.mapped) + offset };
+		}
+
+		OverflowBuffer overflow{};
+		overflow.buffer = overflowPool->acquire(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VulkanMemoryUsage::Upload);
+		if (overflow.buffer->map() != VK_SUCCESS) {
+			throw std::runtime_error("failed to map staging overflow buffer!");
+		}
+		Region region{ overflow.buffer->getBuffer(), 0, overflow.buffer->getMappedMemory() };
+		overflowBuffers.push_back(std::move(overflow));
+		return region;
+	}
+
+	VulkanStagingRing::Region VulkanStagingRing::write(const void* data, VkDeviceSize size, VkDeviceSize alignment)
+	{
+		Region region = allocate(size, alignment);
+		std::memcpy(region.data, data, static_cast<size_t>(size));
+		return region;
+	}
+
+	void VulkanStagingRing::markSubmitted(uint64_t value)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		if (submissions.empty() || submissions.back().end != head) {
+			submissions.push_back(Submission{ value, head });
+		}
+		for (auto& overflow : overflowBuffers) {
+			if (overflow.value == 0) {
+				overflow.value = value;
+			}
+		}
+	}
+
+	void VulkanStagingRing::release(uint64_t completedValue)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		while (!submissions.empty() && submissions.front().value <= completedValue) {
+			tail = submissions.front().end;
+			submissions.pop_front();
+		}
+
+		auto retired = std::partition(overflowBuffers.begin(), overflowBuffers.end(),
+			[completedValue](const OverflowBuffer& overflow) {
+				return overflow.value == 0 || overflow.value > completedValue;
+			});
+		for (auto it = retired; it != overflowBuffers.end(); ++it) {
+			overflowPool->release(std::move(it->buffer), VulkanMemoryUsage::Upload, it->value);
+		}
+		overflowBuffers.erase(retired, overflowBuffers.end());
+		overflowPool->collect(completedValue);
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "VulkanMemoryAllocator.h"
+
+// std
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace VulkanEngine {
+	class VulkanDevice;
+	class VulkanBuffer;
+	class VulkanBufferPool;
+
+	/* Persistently mapped host-visible buffer that uploads copy their source data into.
+		Space is handed out front to back and reclaimed in submission order: everything allocated
+		before markSubmitted(value) is recycled once release() sees a completed value >= value.
+		Values come from whatever tracks upload completion (fence counter or timeline semaphore). */
+	class VulkanStagingRing {
+	public:
+		static constexpr VkDeviceSize DEFAULT_CAPACITY = 32 * 1024 * 1024;
+
+		struct Region {
+			VkBuffer buffer;
+			VkDeviceSize offset;
+			void* data;
+		};
+
+		VulkanStagingRing(VulkanDevice& device, VkDeviceSize capacity = DEFAULT_CAPACITY);
+		~VulkanStagingRing();
+
+		VulkanStagingRing(const VulkanStagingRing&) = delete;
+		VulkanStagingRing& operator=(const VulkanStagingRing&) = delete;
+
+		/* Never fails: when the ring is full (or size exceeds it) the region comes from an overflow
+			buffer that is retired with the same value as the ring space would have been. Overflow
+			buffers are recycled by size class, so repeated large uploads don't reallocate. */
+		Region allocate(VkDeviceSize size, VkDeviceSize alignment = 16);
+		Region write(const void* data, VkDeviceSize size, VkDeviceSize alignment = 16);
+
+		// Tags every allocation made since the previous call with value
+		void markSubmitted(uint64_t value);
+		void release(uint64_t completedValue);
+
+		VkDeviceSize getCapacity() const { return capacity; }
+
+	private:
+		struct Submission {
+			uint64_t value;
+			uint64_t end; // ring position after the submission's last allocation
+		};
+		struct OverflowBuffer {
+			std::unique_ptr<VulkanBuffer> buffer;
+			uint64_t value; // 0 until submitted
+		};
+
+		VulkanDevice& vulkanDevice;
+		VkDeviceSize capacity;
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VulkanAllocation allocation{};
+
+		// positions increase forever; the physical offset is position % capacity
+		uint64_t head = 0;
+		uint64_t tail = 0;
+		std::deque<Submission> submissions;
+		std::vector<OverflowBuffer> overflowBuffers;
+		std::unique_ptr<VulkanBufferPool> overflowPool;
+		std::mutex mutex;
+	};
+}
@@ -1,6 +1,8 @@
 #include "VulkanSwapChain.h"
+#include "Tracer.h"
 
 // std
+#include <algorithm>
 #include <array>
 #include <cstdlib>
 #include <cstring>
@@ -11,13 +13,38 @@
 
 namespace VulkanEngine {
 
-    VulkanSwapChain::VulkanSwapChain(VulkanDevice &deviceRef, VkExtent2D extent)
-        : device{deviceRef}, windowExtent{extent} {
+    VulkanSwapChain::VulkanSwapChain(
+        VulkanDevice &deviceRef,
+        VkExtent2D extent,
+        uint32_t framesInFlight,
+        uint32_t minImageCount,
+        VkPresentModeKHR presentMode)
+        : device{deviceRef},
+          windowExtent{extent},
+          framesInFlight{std::max(framesInFlight, 1u)},
+          requestedImageCount{minImageCount},
+          requestedPresentMode{presentMode},
+          offscreen{deviceRef.isHeadless()} {
         init();
     }
     VulkanSwapChain::VulkanSwapChain(
-        VulkanDevice& deviceRef, VkExtent2D extent, std::shared_ptr<VulkanSwapChain> previous)
-        : device{ deviceRef }, windowExtent{ extent }, oldSwapChain{ previous } {
+        VulkanDevice& deviceRef,
+        VkExtent2D extent,
+        std::shared_ptr<VulkanSwapChain> previous,
+        VkPresentModeKHR presentMode)
+        : device{ deviceRef },
+          windowExtent{ extent },
+          framesInFlight{ previous->framesInFlight },
+          requestedImageCount{ previous->requestedImageCount },
+          requestedPresentMode{ presentMode },
+          offscreen{ deviceRef.isHeadless() },
+          oldSwapChain{ previous } {
+        // frame values keep counting across recreation
+        frameTimeline = previous->frameTimeline;
+        previous->frameTimeline = VK_NULL_HANDLE;
+        submittedFrameValue = previous->submittedFrameValue;
+        frameSubmitValues = previous->frameSubmitValues;
+        currentFrame = previous->currentFrame;
         init();
         oldSwapChain = nullptr;
     }
@@ -43,33 +70,57 @@ namespace VulkanEngine {
         swapChain = nullptr;
       }
 
+      // swapchain images belong to the swapchain, offscreen ones to us
+      for (size_t i = 0; i < offscreenImageAllocations.size(); i++) {
+        device.destroyImage(swapChainImages[i], offscreenImageAllocations[i]);
+      }
+
       for (int i = 0; i < depthImages.size(); i++) {
         vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
-        vkDestroyImage(device.device(), depthImages[i], nullptr);
-        vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+        device.destroyImage(depthImages[i], depthImageAllocations[i]);
       }
 
-      for (auto framebuffer : swapChainFramebuffers) {
-        vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
+      for (auto &frameFramebuffers : swapChainFramebuffers) {
+        for (auto framebuffer : frameFramebuffers) {
+          vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
+        }
       }
 
       vkDestroyRenderPass(device.device(), renderPass, nullptr);
 
       // cleanup synchronization objects
-      for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+      for (size_t i = 0; i < framesInFlight; i++) {
         vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
         vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
-        vkDestroyFence(device.device(), inFlightFences[i], nullptr);
       }
+      // null if a newer swapchain took it over
+      vkDestroySemaphore(device.device(), frameTimeline, nullptr);
+    }
+
+    uint64_t VulkanSwapChain::getCompletedFrameValue() const {
+      uint64_t completedValue = 0;
+      vkGetSemaphoreCounterValue(device.device(), frameTimeline, &completedValue);
+      return completedValue;
+    }
+
+    void VulkanSwapChain::waitForFrame(uint64_t frameValue) const {
+      VkSemaphoreWaitInfo waitInfo = {};
+      waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+      waitInfo.semaphoreCount = 1;
+      waitInfo.pSemaphores = &frameTimeline;
+      waitInfo.pValues = &frameValue;
+      vkWaitSemaphores(device.device(), &waitInfo, std::numeric_limits<uint64_t>::max());
     }
 
     VkResult VulkanSwapChain::acquireNextImage(uint32_t *imageIndex) {
-      vkWaitForFences(
-          device.device(),
-          1,
-          &inFlightFences[currentFrame],
-          VK_TRUE,
-          std::numeric_limits<uint64_t>::max());
+      // the frame that last used this slot has to be done with its command buffers and data
+      waitForFrame(frameSubmitValues[currentFrame]);
+
+      if (offscreen) {
+        *imageIndex = nextOffscreenImage;
+        nextOffscreenImage = (nextOffscreenImage + 1) % static_cast<uint32_t>(swapChainImages.size());
+        return VK_SUCCESS;
+      }
 
       VkResult result = vkAcquireNextImageKHR(
           device.device(),
@@ -83,39 +134,73 @@ namespace VulkanEngine {
     }
 
     VkResult VulkanSwapChain::submitCommandBuffers(
-        const VkCommandBuffer *buffers, uint32_t *imageIndex) {
-      if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
-        vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
-      }
-      imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
+        const VkCommandBuffer *buffers,
+        uint32_t *imageIndex,
+        VkSemaphore uploadSemaphore,
+        uint64_t uploadValue) {
+      waitForFrame(imageSubmitValues[*imageIndex]);
+      uint64_t frameValue = submittedFrameValue + 1;
 
       VkSubmitInfo submitInfo = {};
       submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-      VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
-      VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-      submitInfo.waitSemaphoreCount = 1;
+      // values for binary semaphores are ignored, but the counts have to match
+      VkSemaphore waitSemaphores[2];
+      VkPipelineStageFlags waitStages[2];
+      uint64_t waitValues[2];
+      uint32_t waitCount = 0;
+      if (!offscreen) {
+        waitSemaphores[waitCount] = imageAvailableSemaphores[currentFrame];
+        waitStages[waitCount] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        waitValues[waitCount++] = 0;
+      }
+      if (uploadSemaphore != VK_NULL_HANDLE) {
+        // uploads also gate the transfer stage, where the defragmenter moves geometry around
+        waitSemaphores[waitCount] = uploadSemaphore;
+        waitStages[waitCount] = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+        waitValues[waitCount++] = uploadValue;
+      }
+      submitInfo.waitSemaphoreCount = waitCount;
       submitInfo.pWaitSemaphores = waitSemaphores;
       submitInfo.pWaitDstStageMask = waitStages;
 
+      // offscreen frames have nothing to present, so they only signal the timeline
+      VkSemaphore signalSemaphores[] = {frameTimeline, renderFinishedSemaphores[currentFrame]};
+      uint64_t signalValues[] = {frameValue, 0};
+      submitInfo.signalSemaphoreCount = offscreen ? 1 : 2;
+      submitInfo.pSignalSemaphores = signalSemaphores;
+
+      VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+      timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+      timelineInfo.waitSemaphoreValueCount = waitCount;
+      timelineInfo.pWaitSemaphoreValues = waitValues;
+      timelineInfo.signalSemaphoreValueCount = submitInfo.signalSemaphoreCount;
+      timelineInfo.pSignalSemaphoreValues = signalValues;
+      submitInfo.pNext = &timelineInfo;
+
       submitInfo.commandBufferCount = 1;
       submitInfo.pCommandBuffers = buffers;
 
-      VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
-      submitInfo.signalSemaphoreCount = 1;
-      submitInfo.pSignalSemaphores = signalSemaphores;
+      {
+        TraceZone zone{"Submit"};
+        if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+          throw std::runtime_error("failed to submit draw command buffer!");
+        }
+      }
+      submittedFrameValue = frameValue;
+      frameSubmitValues[currentFrame] = frameValue;
+      imageSubmitValues[*imageIndex] = frameValue;
 
-      vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
-      if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
-          VK_SUCCESS) {
-        throw std::runtime_error("failed to submit draw command buffer!");
+      if (offscreen) {
+        currentFrame = (currentFrame + 1) % framesInFlight;
+        return VK_SUCCESS;
       }
 
       VkPresentInfoKHR presentInfo = {};
       presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
       presentInfo.waitSemaphoreCount = 1;
-      presentInfo.pWaitSemaphores = signalSemaphores;
+      presentInfo.pWaitSemaphores = &renderFinishedSemaphores[currentFrame];
 
       VkSwapchainKHR swapChains[] = {swapChain};
       presentInfo.swapchainCount = 1;
@@ -123,21 +208,31 @@ namespace VulkanEngine {
 
       presentInfo.pImageIndices = imageIndex;
 
-      auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
+      VkResult result;
+      {
+        TraceZone zone{"Present"};
+        result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
+      }
 
-      currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+      currentFrame = (currentFrame + 1) % framesInFlight;
 
       return result;
     }
 
     void VulkanSwapChain::createSwapChain() {
+      if (offscreen) {
+        createOffscreenImages();
+        return;
+      }
       SwapChainSupportDetails swapChainSupport = device.getSwapChainSupport();
 
       VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-      VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+      presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
       VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
-      uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+      uint32_t imageCount = requestedImageCount > 0 ? requestedImageCount
+                                                    : swapChainSupport.capabilities.minImageCount + 1;
+      imageCount = std::max(imageCount, swapChainSupport.capabilities.minImageCount);
       if (swapChainSupport.capabilities.maxImageCount > 0 &&
           imageCount > swapChainSupport.capabilities.maxImageCount) {
         imageCount = swapChainSupport.capabilities.maxImageCount;
@@ -191,6 +286,43 @@ namespace VulkanEngine {
       swapChainExtent = extent;
     }
 
+    void VulkanSwapChain::createOffscreenImages() {
+      swapChainImageFormat = device.findSupportedFormat(
+          {VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB},
+          VK_IMAGE_TILING_OPTIMAL,
+          VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT);
+      swapChainExtent = windowExtent;
+      presentMode = requestedPresentMode;
+
+      // one image per frame in flight is enough, since nothing holds on to them for presentation
+      uint32_t imageCount = std::max(framesInFlight, requestedImageCount);
+      swapChainImages.resize(imageCount);
+      offscreenImageAllocations.resize(imageCount);
+      for (uint32_t i = 0; i < imageCount; i++) {
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = swapChainExtent.width;
+        imageInfo.extent.height = swapChainExtent.height;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = swapChainImageFormat;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.flags = 0;
+
+        device.createImageWithInfo(
+            imageInfo,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            swapChainImages[i],
+            offscreenImageAllocations[i]);
+      }
+    }
+
     void VulkanSwapChain::createImageViews() {
       swapChainImageViews.resize(swapChainImages.size());
       for (size_t i = 0; i < swapChainImages.size(); i++) {
@@ -235,7 +367,8 @@ namespace VulkanEngine {
       colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
       colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
       colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-      colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+      colorAttachment.finalLayout =
+          offscreen ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
       VkAttachmentReference colorAttachmentRef = {};
       colorAttachmentRef.attachment = 0;
@@ -274,26 +407,29 @@ namespace VulkanEngine {
     }
 
     void VulkanSwapChain::createFramebuffers() {
-      swapChainFramebuffers.resize(imageCount());
-      for (size_t i = 0; i < imageCount(); i++) {
-        std::array<VkImageView, 2> attachments = {swapChainImageViews[i], depthImageViews[i]};
-
-        VkExtent2D swapChainExtent = getSwapChainExtent();
-        VkFramebufferCreateInfo framebufferInfo = {};
-        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        framebufferInfo.renderPass = renderPass;
-        framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-        framebufferInfo.pAttachments = attachments.data();
-        framebufferInfo.width = swapChainExtent.width;
-        framebufferInfo.height = swapChainExtent.height;
-        framebufferInfo.layers = 1;
-
-        if (vkCreateFramebuffer(
-                device.device(),
-                &framebufferInfo,
-                nullptr,
-                &swapChainFramebuffers[i]) != VK_SUCCESS) {
-          throw std::runtime_error("failed to create framebuffer!");
+      swapChainFramebuffers.resize(framesInFlight);
+      for (size_t frame = 0; frame < framesInFlight; frame++) {
+        swapChainFramebuffers[frame].resize(imageCount());
+        for (size_t i = 0; i < imageCount(); i++) {
+          std::array<VkImageView, 2> attachments = {swapChainImageViews[i], depthImageViews[frame]};
+
+          VkExtent2D swapChainExtent = getSwapChainExtent();
+          VkFramebufferCreateInfo framebufferInfo = {};
+          framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+          framebufferInfo.renderPass = renderPass;
+          framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+          framebufferInfo.pAttachments = attachments.data();
+          framebufferInfo.width = swapChainExtent.width;
+          framebufferInfo.height = swapChainExtent.height;
+          framebufferInfo.layers = 1;
+
+          if (vkCreateFramebuffer(
+                  device.device(),
+                  &framebufferInfo,
+                  nullptr,
+                  &swapChainFramebuffers[frame][i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create framebuffer!");
+          }
         }
       }
     }
@@ -303,9 +439,10 @@ namespace VulkanEngine {
       swapChainDepthFormat = depthFormat;
       VkExtent2D swapChainExtent = getSwapChainExtent();
 
-      depthImages.resize(imageCount());
-      depthImageMemorys.resize(imageCount());
-      depthImageViews.resize(imageCount());
+      // a depth buffer is only touched by the frame recording into it, not by the image it presents
+      depthImages.resize(framesInFlight);
+      depthImageAllocations.resize(framesInFlight);
+      depthImageViews.resize(framesInFlight);
 
       for (int i = 0; i < depthImages.size(); i++) {
         VkImageCreateInfo imageInfo{};
@@ -319,16 +456,19 @@ namespace VulkanEngine {
         imageInfo.format = depthFormat;
         imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
         imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        imageInfo.usage =
+            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
         imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
         imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
         imageInfo.flags = 0;
 
+        // cleared on load and never stored, so tilers need not back it with real memory
         device.createImageWithInfo(
             imageInfo,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
             depthImages[i],
-            depthImageMemorys[i]);
+            depthImageAllocations[i],
+            VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
 
         VkImageViewCreateInfo viewInfo{};
         viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -348,27 +488,37 @@ namespace VulkanEngine {
     }
 
     void VulkanSwapChain::createSyncObjects() {
-      imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-      renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-      inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-      imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
+      imageAvailableSemaphores.resize(framesInFlight, VK_NULL_HANDLE);
+      renderFinishedSemaphores.resize(framesInFlight, VK_NULL_HANDLE);
+      frameSubmitValues.resize(framesInFlight, 0);
+      imageSubmitValues.resize(imageCount(), 0);
 
       VkSemaphoreCreateInfo semaphoreInfo = {};
       semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-      VkFenceCreateInfo fenceInfo = {};
-      fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-      fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-      for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+      // acquire and present only exist with a real swapchain
+      for (size_t i = 0; i < framesInFlight && !offscreen; i++) {
         if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) !=
                 VK_SUCCESS ||
             vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) !=
-                VK_SUCCESS ||
-            vkCreateFence(device.device(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
+                VK_SUCCESS) {
           throw std::runtime_error("failed to create synchronization objects for a frame!");
         }
       }
+
+      if (frameTimeline == VK_NULL_HANDLE) {
+        VkSemaphoreTypeCreateInfo typeInfo = {};
+        typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        typeInfo.initialValue = 0;
+
+        VkSemaphoreCreateInfo timelineInfo = {};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        timelineInfo.pNext = &typeInfo;
+        if (vkCreateSemaphore(device.device(), &timelineInfo, nullptr, &frameTimeline) != VK_SUCCESS) {
+          throw std::runtime_error("failed to create frame timeline semaphore!");
+        }
+      }
     }
 
     VkSurfaceFormatKHR VulkanSwapChain::chooseSwapSurfaceFormat(
@@ -385,24 +535,48 @@ namespace VulkanEngine {
 
     VkPresentModeKHR VulkanSwapChain::chooseSwapPresentMode(
         const std::vector<VkPresentModeKHR> &availablePresentModes) {
-      for (const auto &availablePresentMode : availablePresentModes) {
-        if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-          std::cout << "Present mode: Mailbox" << std::endl;
-          return availablePresentMode;
-        }
+      // the requested mode, else the other mode with the same tearing behaviour, else FIFO
+      VkPresentModeKHR candidates[] = {requestedPresentMode, VK_PRESENT_MODE_FIFO_KHR};
+      switch (requestedPresentMode) {
+        case VK_PRESENT_MODE_MAILBOX_KHR:
+          candidates[1] = VK_PRESENT_MODE_IMMEDIATE_KHR;
+          break;
+        case VK_PRESENT_MODE_IMMEDIATE_KHR:
+          candidates[1] = VK_PRESENT_MODE_MAILBOX_KHR;
+          break;
+        default:
+          break;
       }
 
-      // for (const auto &availablePresentMode : availablePresentModes) {
-      //   if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
-      //     std::cout << "Present mode: Immediate" << std::endl;
-      //     return availablePresentMode;
-      //   }
-      // }
+      for (VkPresentModeKHR candidate : candidates) {
+        for (const auto &availablePresentMode : availablePresentModes) {
+          if (availablePresentMode == candidate) {
+            std::cout << "Present mode: " << presentModeName(candidate) << std::endl;
+            return candidate;
+          }
+        }
+      }
 
-      std::cout << "Present mode: V-Sync" << std::endl;
+      // the only mode every surface has to support
+      std::cout << "Present mode: " << presentModeName(VK_PRESENT_MODE_FIFO_KHR) << std::endl;
       return VK_PRESENT_MODE_FIFO_KHR;
     }
 
+    const char* VulkanSwapChain::presentModeName(VkPresentModeKHR presentMode) {
+      switch (presentMode) {
+        case VK_PRESENT_MODE_IMMEDIATE_KHR:
+          return "Immediate";
+        case VK_PRESENT_MODE_MAILBOX_KHR:
+          return "Mailbox";
+        case VK_PRESENT_MODE_FIFO_KHR:
+          return "V-Sync";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+          return "Relaxed V-Sync";
+        default:
+          return "Unknown";
+      }
+    }
+
     VkExtent2D VulkanSwapChain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities) {
       if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
         return capabilities.currentExtent;
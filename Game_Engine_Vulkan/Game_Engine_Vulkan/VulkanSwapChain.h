@@ -12,22 +12,43 @@
 
 namespace VulkanEngine {
 
+/* On a headless device (no surface) the swapchain is emulated with offscreen color images:
+    acquire hands them out round robin, submit skips presentation, and the render pass leaves
+    them in TRANSFER_SRC_OPTIMAL so they can be read back. */
 class VulkanSwapChain {
     public:
-    static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
+    static constexpr uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
 
-    VulkanSwapChain(VulkanDevice& deviceRef, VkExtent2D windowExtent);
+    /* minImageCount 0 asks for one image more than the surface minimum. presentMode falls back
+        to the nearest supported mode, FIFO at worst. */
     VulkanSwapChain(
-        VulkanDevice& deviceRef, VkExtent2D windowExtent, std::shared_ptr<VulkanSwapChain> previous);
+        VulkanDevice& deviceRef,
+        VkExtent2D windowExtent,
+        uint32_t framesInFlight = DEFAULT_FRAMES_IN_FLIGHT,
+        uint32_t minImageCount = 0,
+        VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR);
+    // Keeps the frames in flight, image count and frame timeline of previous
+    VulkanSwapChain(
+        VulkanDevice& deviceRef,
+        VkExtent2D windowExtent,
+        std::shared_ptr<VulkanSwapChain> previous,
+        VkPresentModeKHR presentMode);
     ~VulkanSwapChain();
 
     VulkanSwapChain(const VulkanSwapChain &) = delete;
     VulkanSwapChain& operator=(const VulkanSwapChain &) = delete;
 
-    VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
+    // Framebuffer for swapchain image index, using the depth attachment of the frame being recorded
+    VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[currentFrame][index]; }
     VkRenderPass getRenderPass() { return renderPass; }
     VkImageView getImageView(int index) { return swapChainImageViews[index]; }
+    VkImage getImage(int index) { return swapChainImages[index]; }
+    bool isOffscreen() const { return offscreen; }
     size_t imageCount() { return swapChainImages.size(); }
+    uint32_t getFramesInFlight() const { return framesInFlight; }
+    // The mode actually in use, which may differ from the requested one
+    VkPresentModeKHR getPresentMode() const { return presentMode; }
+    static const char* presentModeName(VkPresentModeKHR presentMode);
     VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
     VkExtent2D getSwapChainExtent() { return swapChainExtent; }
     uint32_t width() { return swapChainExtent.width; }
@@ -39,7 +60,22 @@ class VulkanSwapChain {
     VkFormat findDepthFormat();
 
     VkResult acquireNextImage(uint32_t *imageIndex);
-    VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
+    // The submission also waits for uploadValue on uploadSemaphore (a timeline) when one is given
+    VkResult submitCommandBuffers(
+        const VkCommandBuffer *buffers,
+        uint32_t *imageIndex,
+        VkSemaphore uploadSemaphore = VK_NULL_HANDLE,
+        uint64_t uploadValue = 0);
+
+    /* Frame timeline: the n-th submitted frame signals value n on one timeline semaphore, so
+        "has frame n retired?" is a counter comparison instead of a fence per frame. The
+        timeline survives swapchain recreation. */
+    VkSemaphore getFrameTimeline() const { return frameTimeline; }
+    // Value the most recent submission signals; the frame being recorded will signal this + 1
+    uint64_t getSubmittedFrameValue() const { return submittedFrameValue; }
+    uint64_t getCompletedFrameValue() const;
+    bool isFrameComplete(uint64_t frameValue) const { return getCompletedFrameValue() >= frameValue; }
+    void waitForFrame(uint64_t frameValue) const;
 
     bool compareSwapFormats(const VulkanSwapChain& swapChain) const {
         return swapChain.swapChainDepthFormat == swapChainDepthFormat &&
@@ -49,6 +85,7 @@ class VulkanSwapChain {
     private:
     void init();
     void createSwapChain();
+    void createOffscreenImages();
     void createImageViews();
     void createDepthResources();
     void createRenderPass();
@@ -66,25 +103,36 @@ class VulkanSwapChain {
     VkFormat swapChainDepthFormat;
     VkExtent2D swapChainExtent;
 
-    std::vector<VkFramebuffer> swapChainFramebuffers;
+    std::vector<std::vector<VkFramebuffer>> swapChainFramebuffers; // [frame in flight][image]
     VkRenderPass renderPass;
 
+    // one per frame in flight; depth never outlives the render pass so it can stay transient
     std::vector<VkImage> depthImages;
-    std::vector<VkDeviceMemory> depthImageMemorys;
+    std::vector<VulkanAllocation> depthImageAllocations;
     std::vector<VkImageView> depthImageViews;
     std::vector<VkImage> swapChainImages;
     std::vector<VkImageView> swapChainImageViews;
+    std::vector<VulkanAllocation> offscreenImageAllocations; // only when offscreen
 
     VulkanDevice &device;
     VkExtent2D windowExtent;
-
-    VkSwapchainKHR swapChain;
+    uint32_t framesInFlight;
+    uint32_t requestedImageCount;
+    VkPresentModeKHR requestedPresentMode;
+    VkPresentModeKHR presentMode;
+
+    bool offscreen;
+    uint32_t nextOffscreenImage = 0;
+    VkSwapchainKHR swapChain = VK_NULL_HANDLE;
     std::shared_ptr<VulkanSwapChain> oldSwapChain;
 
+    // binary semaphores remain for acquire and present, which don't take timelines
     std::vector<VkSemaphore> imageAvailableSemaphores;
     std::vector<VkSemaphore> renderFinishedSemaphores;
-    std::vector<VkFence> inFlightFences;
-    std::vector<VkFence> imagesInFlight;
+    VkSemaphore frameTimeline = VK_NULL_HANDLE;
+    uint64_t submittedFrameValue = 0;
+    std::vector<uint64_t> frameSubmitValues; // per frame in flight, last value it signaled
+    std::vector<uint64_t> imageSubmitValues; // per image, last value that rendered into it
     size_t currentFrame = 0;
 };
 
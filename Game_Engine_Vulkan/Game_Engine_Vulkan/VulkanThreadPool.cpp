@@ -0,0 +1,56 @@
+#include "VulkanThreadPool.h"
+#include "Tracer.h"
+
+// std
+#include <algorithm>
+#include <string>
+
+namespace VulkanEngine {
+	uint32_t VulkanThreadPool::defaultThreadCount()
+	{
+		uint32_t cores = std::thread::hardware_concurrency();
+		return std::max(cores, 2u) - 1;
+	}
+
+	VulkanThreadPool::VulkanThreadPool(uint32_t threadCount)
+	{
+		threadCount = std::max(threadCount, 1u);
+		workers.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++) {
+			workers.emplace_back([this, i] {
+				Tracer::setThreadName("Worker " + std::to_string(i));
+				workerLoop();
+			});
+		}
+	}
+
+	VulkanThreadPool::~VulkanThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			stopping = true;
+		}
+		taskAvailable.notify_all();
+		// queued tasks still run, so nobody is left waiting on a future that never resolves
+		for (auto& worker : workers) {
+			worker.join();
+		}
+	}
+
+	void VulkanThreadPool::workerLoop()
+	{
+		for (;;) {
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock{ mutex };
+				taskAvailable.wait(lock, [this] { return stopping || !tasks.empty(); });
+				if (tasks.empty()) {
+					return;
+				}
+				task = std::move(tasks.front());
+				tasks.pop_front();
+			}
+			task();
+		}
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+// std
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace VulkanEngine {
+	/* Fixed set of worker threads running queued tasks in FIFO order. submit() hands back a
+		std::future, so results and exceptions reach whoever waits on it. */
+	class VulkanThreadPool {
+	public:
+		// one worker per core, leaving one for the thread that submits
+		static uint32_t defaultThreadCount();
+
+		explicit VulkanThreadPool(uint32_t threadCount = defaultThreadCount());
+		~VulkanThreadPool();
+
+		VulkanThreadPool(const VulkanThreadPool&) = delete;
+		VulkanThreadPool& operator=(const VulkanThreadPool&) = delete;
+
+		uint32_t size() const { return static_cast<uint32_t>(workers.size()); }
+
+		template <typename F>
+		std::future<std::invoke_result_t<F>> submit(F&& task) {
+			using Result = std::invoke_result_t<F>;
+			// std::function needs something copyable, packaged_task is move-only
+			auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+			std::future<Result> future = packaged->get_future();
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				tasks.emplace_back([packaged] { (*packaged)(); });
+			}
+			taskAvailable.notify_one();
+			return future;
+		}
+
+	private:
+		void workerLoop();
+
+		std::vector<std::thread> workers;
+		std::deque<std::function<void()>> tasks;
+		std::mutex mutex;
+		std::condition_variable taskAvailable;
+		bool stopping = false;
+	};
+}
@@ -0,0 +1,282 @@
+#include "VulkanUploader.h"
+#include "VulkanDevice.h"
+#include "VulkanStagingRing.h"
+
+// std
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace VulkanEngine {
+	VulkanUploader::VulkanUploader(VulkanDevice& device, uint32_t queueFamilyIndex, VkQueue queue)
+		: vulkanDevice{ device }, queue{ queue }
+	{
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = queueFamilyIndex;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		if (vkCreateCommandPool(vulkanDevice.device(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create upload command pool!");
+		}
+
+		VkSemaphoreTypeCreateInfo typeInfo{};
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		typeInfo.initialValue = 0;
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext = &typeInfo;
+		if (vkCreateSemaphore(vulkanDevice.device(), &semaphoreInfo, nullptr, &timelineSemaphore) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create upload timeline semaphore!");
+		}
+	}
+
+	VulkanUploader::~VulkanUploader()
+	{
+		wait(flush());
+		vkDestroySemaphore(vulkanDevice.device(), timelineSemaphore, nullptr);
+		vkDestroyCommandPool(vulkanDevice.device(), commandPool, nullptr);
+	}
+
+	VkCommandBuffer VulkanUploader::acquireCommandBuffer()
+	{
+		VkCommandBuffer commandBuffer;
+		if (freeCommandBuffers.empty()) {
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandPool = commandPool;
+			allocInfo.commandBufferCount = 1;
+			if (vkAllocateCommandBuffers(vulkanDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+				throw std::runtime_error("failed to allocate upload command buffer!");
+			}
+		}
+		else {
+			commandBuffer = freeCommandBuffers.back();
+			freeCommandBuffers.pop_back();
+		}
+		return commandBuffer;
+	}
+
+	void VulkanUploader::uploadBuffer(const void* data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset)
+	{
+		collect();
+		std::lock_guard<std::mutex> lock{ mutex };
+		pendingBatch.uploadBuffer(data, size, dstBuffer, dstOffset);
+	}
+
+	UploadTicket VulkanUploader::flush()
+	{
+		return submit(pendingBatch);
+	}
+
+	UploadTicket VulkanUploader::submit(VulkanUploadBatch& batch)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		if (batch.empty() && pendingBatch.empty()) {
+			return UploadTicket{ nextValue - 1 };
+		}
+
+		VkCommandBuffer commandBuffer = acquireCommandBuffer();
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("failed to begin upload command buffer!");
+		}
+		pendingBatch.record(commandBuffer);
+		if (&batch != &pendingBatch) {
+			batch.writeStaging();
+			batch.record(commandBuffer);
+		}
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to record upload command buffer!");
+		}
+
+		uint64_t signalValue = nextValue++;
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &signalValue;
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &timelineSemaphore;
+		if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+			throw std::runtime_error("failed to submit upload command buffer!");
+		}
+
+		vulkanDevice.stagingRing().markSubmitted(signalValue);
+		inFlight.push_back(Batch{ commandBuffer, signalValue });
+		pendingBatch.clear();
+		batch.clear();
+		return UploadTicket{ signalValue };
+	}
+
+	bool VulkanUploader::isComplete(UploadTicket ticket)
+	{
+		uint64_t completedValue = 0;
+		vkGetSemaphoreCounterValue(vulkanDevice.device(), timelineSemaphore, &completedValue);
+		return completedValue >= ticket.value;
+	}
+
+	bool VulkanUploader::isIdle()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			if (!pendingBatch.empty()) {
+				return false;
+			}
+		}
+		return isComplete(getLastSubmitted());
+	}
+
+	void VulkanUploader::wait(UploadTicket ticket)
+	{
+		if (ticket.isNull()) {
+			return;
+		}
+		VkSemaphoreWaitInfo waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &timelineSemaphore;
+		waitInfo.pValues = &ticket.value;
+		vkWaitSemaphores(vulkanDevice.device(), &waitInfo, std::numeric_limits<uint64_t>::max());
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		collectLocked(ticket.value);
+	}
+
+	void VulkanUploader::collect()
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		uint64_t completedValue = 0;
+		vkGetSemaphoreCounterValue(vulkanDevice.device(), timelineSemaphore, &completedValue);
+		collectLocked(completedValue);
+	}
+
+	size_t VulkanUploadBatch::regionCount() const
+	{
+		size_t count = 0;
+		for (auto& kv : bufferCopies) {
+			count += kv.second.size();
+		}
+		for (auto& kv : imageCopies) {
+			count += kv.second.size();
+		}
+		return count;
+	}
+
+	void VulkanUploadBatch::uploadBuffer(const void* data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset)
+	{
+		if (!stageImmediately) {
+			stagedBuffers.push_back(StagedBuffer{ keepHostCopy(data, size), size, dstBuffer, dstOffset });
+			return;
+		}
+		auto staging = uploader.getDevice().stagingRing().write(data, size);
+
+		VkBufferCopy region{};
+		region.srcOffset = staging.offset;
+		region.dstOffset = dstOffset;
+		region.size = size;
+		copyBuffer(staging.buffer, dstBuffer, region);
+	}
+
+	void VulkanUploadBatch::uploadImage(const void* data, VkDeviceSize size, VkImage dstImage, const VkBufferImageCopy& region)
+	{
+		if (!stageImmediately) {
+			stagedImages.push_back(StagedImage{ keepHostCopy(data, size), size, dstImage, region });
+			return;
+		}
+		auto staging = uploader.getDevice().stagingRing().write(data, size);
+
+		VkBufferImageCopy stagedRegion = region;
+		stagedRegion.bufferOffset = staging.offset;
+		copyBufferToImage(staging.buffer, dstImage, stagedRegion);
+	}
+
+	size_t VulkanUploadBatch::keepHostCopy(const void* data, VkDeviceSize size)
+	{
+		size_t hostOffset = hostData.size();
+		hostData.resize(hostOffset + static_cast<size_t>(size));
+		std::memcpy(hostData.data() + hostOffset, data, static_cast<size_t>(size));
+		return hostOffset;
+	}
+
+	void VulkanUploadBatch::writeStaging()
+	{
+		VulkanStagingRing& stagingRing = uploader.getDevice().stagingRing();
+		for (auto& staged : stagedBuffers) {
+			auto staging = stagingRing.write(hostData.data() + staged.hostOffset, staged.size);
+
+			VkBufferCopy region{};
+			region.srcOffset = staging.offset;
+			region.dstOffset = staged.dstOffset;
+			region.size = staged.size;
+			copyBuffer(staging.buffer, staged.dstBuffer, region);
+		}
+		for (auto& staged : stagedImages) {
+			auto staging = stagingRing.write(hostData.data() + staged.hostOffset, staged.size);
+
+			VkBufferImageCopy region = staged.region;
+			region.bufferOffset = staging.offset;
+			copyBufferToImage(staging.buffer, staged.dstImage, region);
+		}
+		stagedBuffers.clear();
+		stagedImages.clear();
+		hostData.clear();
+	}
+
+	void VulkanUploadBatch::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, const VkBufferCopy& region)
+	{
+		bufferCopies[{ srcBuffer, dstBuffer }].push_back(region);
+	}
+
+	void VulkanUploadBatch::copyBufferToImage(VkBuffer srcBuffer, VkImage dstImage, const VkBufferImageCopy& region)
+	{
+		imageCopies[{ srcBuffer, dstImage }].push_back(region);
+	}
+
+	UploadTicket VulkanUploadBatch::submit()
+	{
+		return uploader.submit(*this);
+	}
+
+	void VulkanUploadBatch::record(VkCommandBuffer commandBuffer) const
+	{
+		for (auto& kv : bufferCopies) {
+			vkCmdCopyBuffer(commandBuffer, kv.first.first, kv.first.second,
+				static_cast<uint32_t>(kv.second.size()), kv.second.data());
+		}
+		for (auto& kv : imageCopies) {
+			vkCmdCopyBufferToImage(commandBuffer, kv.first.first, kv.first.second,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(kv.second.size()), kv.second.data());
+		}
+	}
+
+	void VulkanUploadBatch::clear()
+	{
+		bufferCopies.clear();
+		imageCopies.clear();
+		stagedBuffers.clear();
+		stagedImages.clear();
+		hostData.clear();
+	}
+
+	void VulkanUploader::collectLocked(uint64_t completedValue)
+	{
+		while (!inFlight.empty() && inFlight.front().value <= completedValue) {
+			vkResetCommandBuffer(inFlight.front().commandBuffer, 0);
+			freeCommandBuffers.push_back(inFlight.front().commandBuffer);
+			inFlight.pop_front();
+		}
+		vulkanDevice.stagingRing().release(completedValue);
+	}
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <deque>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace VulkanEngine {
+	class VulkanDevice;
+	class VulkanUploader;
+
+	// Identifies a submitted upload; complete once the uploader's timeline semaphore reaches value.
+	struct UploadTicket {
+		uint64_t value = 0;
+
+		bool isNull() const { return value == 0; }
+	};
+
+	/* Gathers buffer-to-buffer and buffer-to-image regions so they are recorded into one command
+		buffer and go out in one submission. Regions sharing a source and destination are merged
+		into a single vkCmdCopyBuffer / vkCmdCopyBufferToImage.
+		Images must already be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL. */
+	class VulkanUploadBatch {
+	public:
+		explicit VulkanUploadBatch(VulkanUploader& uploader) : uploader{ uploader } {}
+
+		VulkanUploadBatch(const VulkanUploadBatch&) = delete;
+		VulkanUploadBatch& operator=(const VulkanUploadBatch&) = delete;
+
+		/* The upload variants keep a copy of data until submit, when it is written to the staging
+			ring. Staging space is reclaimed in submission order, so a batch that is still being
+			filled must not hold any of it. */
+		void uploadBuffer(const void* data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset = 0);
+		void uploadImage(const void* data, VkDeviceSize size, VkImage dstImage, const VkBufferImageCopy& region);
+		void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, const VkBufferCopy& region);
+		void copyBufferToImage(VkBuffer srcBuffer, VkImage dstImage, const VkBufferImageCopy& region);
+
+		bool empty() const {
+			return bufferCopies.empty() && imageCopies.empty() && stagedBuffers.empty() && stagedImages.empty();
+		}
+		size_t regionCount() const;
+
+		// Records and submits every gathered region, leaving the batch empty
+		UploadTicket submit();
+
+	private:
+		friend class VulkanUploader;
+		struct StagedBuffer {
+			size_t hostOffset;
+			VkDeviceSize size;
+			VkBuffer dstBuffer;
+			VkDeviceSize dstOffset;
+		};
+		struct StagedImage {
+			size_t hostOffset;
+			VkDeviceSize size;
+			VkImage dstImage;
+			VkBufferImageCopy region;
+		};
+
+		// the uploader's own pending batch stages immediately; it is part of every submission
+		VulkanUploadBatch(VulkanUploader& uploader, bool stageImmediately)
+			: uploader{ uploader }, stageImmediately{ stageImmediately } {}
+
+		size_t keepHostCopy(const void* data, VkDeviceSize size);
+		void writeStaging();
+		void record(VkCommandBuffer commandBuffer) const;
+		void clear();
+
+		VulkanUploader& uploader;
+		bool stageImmediately = false;
+		std::map<std::pair<VkBuffer, VkBuffer>, std::vector<VkBufferCopy>> bufferCopies;
+		std::map<std::pair<VkBuffer, VkImage>, std::vector<VkBufferImageCopy>> imageCopies;
+
+		std::vector<char> hostData;
+		std::vector<StagedBuffer> stagedBuffers;
+		std::vector<StagedImage> stagedImages;
+	};
+
+	/* Records copies out of the device's staging ring into batches and submits them on the
+		transfer queue (the graphics queue when there is no dedicated transfer family).
+		Each submission signals a timeline semaphore; the returned ticket is waited on by
+		whoever consumes the data, so nothing blocks the CPU. */
+	class VulkanUploader {
+	public:
+		VulkanUploader(VulkanDevice& device, uint32_t queueFamilyIndex, VkQueue queue);
+		~VulkanUploader();
+
+		VulkanUploader(const VulkanUploader&) = delete;
+		VulkanUploader& operator=(const VulkanUploader&) = delete;
+
+		VulkanDevice& getDevice() const { return vulkanDevice; }
+
+		// Copies data into staging now; the GPU copy goes into the uploader's own pending batch
+		void uploadBuffer(const void* data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset = 0);
+
+		// Submits the pending batch. Returns the last submitted ticket if nothing was recorded.
+		UploadTicket flush();
+		/* Submits batch, together with anything pending, in one command buffer. Staging space is
+			tagged per submission, so pending regions can't be left behind for a later one. */
+		UploadTicket submit(VulkanUploadBatch& batch);
+
+		bool isComplete(UploadTicket ticket);
+		// Nothing pending and every submission finished
+		bool isIdle();
+		void wait(UploadTicket ticket);
+		// Recycles command buffers and staging space of batches that have finished
+		void collect();
+
+		VkSemaphore getTimelineSemaphore() const { return timelineSemaphore; }
+		UploadTicket getLastSubmitted() const { return UploadTicket{ nextValue - 1 }; }
+
+	private:
+		struct Batch {
+			VkCommandBuffer commandBuffer;
+			uint64_t value;
+		};
+
+		VkCommandBuffer acquireCommandBuffer();
+		void collectLocked(uint64_t completedValue);
+
+		VulkanDevice& vulkanDevice;
+		VkQueue queue;
+		VkCommandPool commandPool = VK_NULL_HANDLE;
+		VkSemaphore timelineSemaphore = VK_NULL_HANDLE;
+
+		VulkanUploadBatch pendingBatch{ *this, true };
+		std::deque<Batch> inFlight;
+		std::vector<VkCommandBuffer> freeCommandBuffers;
+		uint64_t nextValue = 1;
+		std::mutex mutex;
+	};
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <functional>
+#include <type_traits>
+#include <vector>
 
 namespace VulkanEngine {
 
@@ -11,4 +13,29 @@ namespace VulkanEngine {
 		(hashCombine(seed, rest), ...);
 	};
 
+	/* Everything a cached recording depends on, kept byte for byte rather than hashed, so two
+		different inputs can never compare equal. */
+	class RecordingKey {
+	public:
+		template <typename... T>
+		void add(const T&... values) {
+			(append(values), ...);
+		}
+		// Keeps the capacity, so a key rebuilt every frame doesn't allocate
+		void clear() { bytes.clear(); }
+
+		bool operator==(const RecordingKey& other) const { return bytes == other.bytes; }
+		bool operator!=(const RecordingKey& other) const { return bytes != other.bytes; }
+
+	private:
+		template <typename T>
+		void append(const T& value) {
+			static_assert(std::is_trivially_copyable<T>::value, "RecordingKey only holds plain values");
+			const unsigned char* data = reinterpret_cast<const unsigned char*>(&value);
+			bytes.insert(bytes.end(), data, data + sizeof(T));
+		}
+
+		std::vector<unsigned char> bytes;
+	};
+
 }
\ No newline at end of file
@@ -2,14 +2,25 @@
 
 #include <stdexcept>
 namespace VulkanEngine {
-	VulkanWindow::VulkanWindow(int w, int h, std::string name) : width{ w }, height{ h }, windowName{ name }
+	VulkanWindow::VulkanWindow(int w, int h, std::string name, bool headless)
+		: width{ w }, height{ h }, headless{ headless }, windowName{ name }
 	{
-		initWindow();
+		if (!headless) {
+			initWindow();
+		}
 	}
 	VulkanWindow::~VulkanWindow()
 	{
-		glfwDestroyWindow(window);
-		glfwTerminate();
+		if (!headless) {
+			glfwDestroyWindow(window);
+			glfwTerminate();
+		}
+	}
+	void VulkanWindow::pollEvents()
+	{
+		if (!headless) {
+			glfwPollEvents();
+		}
 	}
 	void VulkanWindow::initWindow()
 	{
@@ -29,6 +40,9 @@ namespace VulkanEngine {
 		vulkanWindow->height = height;
 	}
 	void VulkanWindow::createWindowSurface(VkInstance instance, VkSurfaceKHR* surface) {
+		if (headless) {
+			throw std::runtime_error("failed to create window surface: window is headless");
+		}
 		if (glfwCreateWindowSurface(instance, window, nullptr, surface) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create window surface");
 		}
@@ -8,13 +8,16 @@
 namespace VulkanEngine {
 	class VulkanWindow {
 	public:
-		VulkanWindow(int width, int height, std::string name); // constructor
+		// A headless window never touches GLFW: no surface, no input, and it never closes by itself
+		VulkanWindow(int width, int height, std::string name, bool headless = false); // constructor
 		~VulkanWindow(); // destructor
 
 		VulkanWindow(const VulkanWindow&) = delete;
 		VulkanWindow& operator=(const VulkanWindow&) = delete;
 
-		bool shouldClose() { return glfwWindowShouldClose(window); }
+		bool shouldClose() { return !headless && glfwWindowShouldClose(window); }
+		bool isHeadless() const { return headless; }
+		void pollEvents();
 		VkExtent2D getExtent() { return { static_cast<uint32_t>(width), static_cast<uint32_t>(height) }; }
 		bool wasWindowResized() { return framebufferResized; }
 		void resetWindowResizedFlag() { framebufferResized = false; }
@@ -28,10 +31,11 @@ namespace VulkanEngine {
 		// private variables
 		int width;
 		int height;
+		bool headless;
 		bool framebufferResized = false;
 
 		std::string windowName;
-		GLFWwindow* window; // variable that is a pointer to GLFW window for glfwCreateWindow function
+		GLFWwindow* window = nullptr; // variable that is a pointer to GLFW window for glfwCreateWindow function
 
 	};
 }
\ No newline at end of file
@@ -6,14 +6,11 @@ namespace VulkanEngine {
 	};
 
 	WireframeSystem::WireframeSystem(VulkanDevice& device, VkRenderPass renderPass,
-		VkDescriptorSetLayout globalSetLayout) : vulkanDevice{ device }
+		VkDescriptorSetLayout globalSetLayout,
+		VulkanPipelineQueue& pipelineQueue) : VulkanRenderSystem{ device }
 	{
 		createPipelineLayout(globalSetLayout);
-		createPipeline(renderPass);
-	}
-	WireframeSystem::~WireframeSystem()
-	{
-		vkDestroyPipelineLayout(vulkanDevice.device(), pipelineLayout, nullptr);
+		createPipeline(renderPass, pipelineQueue);
 	}
 	void WireframeSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
 	{
@@ -35,39 +32,39 @@ namespace VulkanEngine {
 			throw std::runtime_error("failed to create pipeline layout!");
 		}
 	}
-	void WireframeSystem::createPipeline(VkRenderPass renderPass)
+	void WireframeSystem::createPipeline(VkRenderPass renderPass, VulkanPipelineQueue& pipelineQueue)
 	{
 		assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
-		PipelineConfigInfo pipelineConfig{};
-		VulkanPipeline::defaultPipelineConfigInfo(pipelineConfig);
-		pipelineConfig.renderPass = renderPass;
-		pipelineConfig.pipelineLayout = pipelineLayout;
+		auto pipelineConfig = std::make_unique<PipelineConfigInfo>();
+		VulkanPipeline::defaultPipelineConfigInfo(*pipelineConfig);
+		pipelineConfig->renderPass = renderPass;
+		pipelineConfig->pipelineLayout = pipelineLayout;
 
-		pipelineConfig.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
-		pipelineConfig.rasterizationInfo.polygonMode = VK_POLYGON_MODE_LINE;
-		pipelineConfig.rasterizationInfo.lineWidth = 5.0f;
+		pipelineConfig->inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+		pipelineConfig->rasterizationInfo.polygonMode = VK_POLYGON_MODE_LINE;
+		pipelineConfig->rasterizationInfo.lineWidth = 5.0f;
 
-		vulkanPipeline = std::make_unique<VulkanPipeline>(
-			vulkanDevice,
+		vulkanPipeline = pipelineQueue.submit(
 			"shaders/wireframe_shader.vert.spv",
 			"shaders/wireframe_shader.frag.spv",
-			pipelineConfig);
+			std::move(pipelineConfig));
 	}
 
 	void WireframeSystem::render(FrameInfo& frameInfo)
 	{
-		vulkanPipeline->bind(frameInfo.commandBuffer);
+		vulkanPipeline->bind(frameInfo.commandBuffer, frameInfo.commandStats);
 
-		vkCmdBindDescriptorSets(
+		VulkanCommands::bindDescriptorSets(
+			frameInfo.commandStats,
 			frameInfo.commandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
 			pipelineLayout,
 			0,
 			1,
 			&frameInfo.globalDescriptorSet,
-			0,
-			nullptr
+			1,
+			&frameInfo.globalUboOffset
 		);
 		for (auto& kv : frameInfo.gameMeshObjects) {
 			auto& obj = kv.second;
@@ -78,15 +75,15 @@ namespace VulkanEngine {
 			push.modelMatrix = obj.transform.mat4();
 			//push.normalMatrix = obj.transform.normalMatrix();
 
-			vkCmdPushConstants(
+			VulkanCommands::pushConstants(
+				frameInfo.commandStats,
 				frameInfo.commandBuffer,
 				pipelineLayout,
 				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
 				0,
 				sizeof(ShapePushConstant),
 				&push);
-			obj.model->bind(frameInfo.commandBuffer);
-			obj.model->draw(frameInfo.commandBuffer);
+			obj.model->draw(frameInfo.commandBuffer, frameInfo.commandStats);
 		}
 	}
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 #include "VulkanCamera.h"
 #include "VulkanPipeline.h"
+#include "VulkanPipelineQueue.h"
+#include "VulkanRenderSystem.h"
 #include "VulkanDevice.h"
 #include "VulkanGameObject.h"
 #include "VulkanFrameInfo.h"
@@ -9,15 +11,15 @@
 #include <vector>
 
 namespace VulkanEngine {
-	class WireframeSystem {
+	class WireframeSystem : public VulkanRenderSystem {
 	public:
 		WireframeSystem(
 			VulkanDevice& device,
 			VkRenderPass renderPass,
-			VkDescriptorSetLayout globalSetLayout
+			VkDescriptorSetLayout globalSetLayout,
+			VulkanPipelineQueue& pipelineQueue
 		);
 
-		~WireframeSystem();
 
 		WireframeSystem(const WireframeSystem&) = delete; // deleting copy constructors
 		WireframeSystem& operator=(const WireframeSystem&) = delete;
@@ -26,11 +28,6 @@ namespace VulkanEngine {
 
 	private:
 		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-		void createPipeline(VkRenderPass renderPass);
-
-		VulkanDevice& vulkanDevice;
-
-		std::unique_ptr<VulkanPipeline> vulkanPipeline;
-		VkPipelineLayout pipelineLayout;
+		void createPipeline(VkRenderPass renderPass, VulkanPipelineQueue& pipelineQueue);
 	};
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "PointLightSystem.h"
 #include "Equations.h"
 #include "print_utility.h"
+#include "Tracer.h"
 
 #define _USE_MATH_DEFINES
 #define GLM_FORCE_RADIANS
@@ -14,6 +15,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 #include <chrono>
@@ -21,12 +23,19 @@
 #include <math.h>
 
 namespace VulkanEngine {
-	FirstApp::FirstApp() {
+	FirstApp::FirstApp(const EngineConfig& engineConfig) : config{ engineConfig } {
 		globalPool =
 			VulkanDescriptorPool::Builder(vulkanDevice)
-			.setMaxSets(VulkanSwapChain::MAX_FRAMES_IN_FLIGHT)
-			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VulkanSwapChain::MAX_FRAMES_IN_FLIGHT)
+			.setMaxSets(vulkanRenderer.getFramesInFlight())
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, vulkanRenderer.getFramesInFlight())
 			.build();
+		defragmenter.registerPool(geometryPool);
+		// one slot per worker, plus one for this thread
+		vulkanRenderer.setRecordingSlotCount(threadPool.size() + 1);
+		staticBatchCommandBuffer = vulkanRenderer.createCachedCommandBuffer();
+		if (gpuProfiler.isPipelineStatisticsSupported() && vulkanDevice.isInheritedQueriesSupported()) {
+			vulkanRenderer.setInheritedPipelineStatistics(VulkanGpuProfiler::PIPELINE_STATISTICS);
+		}
 		loadGameObjects();
 	}
 	FirstApp::~FirstApp()
@@ -34,51 +43,47 @@ namespace VulkanEngine {
 	}
 	void FirstApp::run()
 	{
-		std::vector<std::unique_ptr<VulkanBuffer>> uboBuffers(VulkanSwapChain::MAX_FRAMES_IN_FLIGHT);
-		for (int i = 0; i < uboBuffers.size(); i++) {
-			uboBuffers[i] = std::make_unique<VulkanBuffer>(
-				vulkanDevice,
-				sizeof(GlobalUbo),
-				1,
-				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-			);
-			uboBuffers[i]->map();
-		}
+		// GlobalUbo is streamed through the renderer's frame allocator; the set only needs a dynamic offset
+		VulkanFrameAllocator& frameAllocator = vulkanRenderer.getFrameAllocator();
 
 		auto globalSetLayout =
 			VulkanDescriptorSetLayout::Builder(vulkanDevice)
-			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS)
 			.build();
 
-		std::vector<VkDescriptorSet> globalDescriptorSets(VulkanSwapChain::MAX_FRAMES_IN_FLIGHT);
-		for (int i = 0; i < globalDescriptorSets.size(); i++) {
-			auto bufferInfo = uboBuffers[i]->descriptorInfo();
-			VulkanDescriptorWriter(*globalSetLayout, *globalPool)
-				.writeBuffer(0, &bufferInfo)
-				.build(globalDescriptorSets[i]);
-		}
+		VkDescriptorSet globalDescriptorSet;
+		auto bufferInfo = frameAllocator.descriptorInfo(sizeof(GlobalUbo));
+		VulkanDescriptorWriter(*globalSetLayout, *globalPool)
+			.writeBuffer(0, &bufferInfo)
+			.build(globalDescriptorSet);
 
+		// the systems only queue their pipelines, which compile side by side on the thread pool until first used
+		VulkanPipelineQueue pipelineQueue{ vulkanDevice, threadPool };
 		SimpleRenderSystem simpleRenderSystem{
 			  vulkanDevice,
 			  vulkanRenderer.getSwapChainRenderPass(),
-			  globalSetLayout->getDescriptorSetLayout() 
+			  globalSetLayout->getDescriptorSetLayout(),
+			  pipelineQueue
 		};
 		PlayerSystem playerSystem{
 			  vulkanDevice,
 			  vulkanRenderer.getSwapChainRenderPass(),
-			  globalSetLayout->getDescriptorSetLayout()
+			  globalSetLayout->getDescriptorSetLayout(),
+			  pipelineQueue
 		};
 		WireframeSystem wireframeSystem{
 			  vulkanDevice,
 			  vulkanRenderer.getSwapChainRenderPass(),
-			  globalSetLayout->getDescriptorSetLayout()
+			  globalSetLayout->getDescriptorSetLayout(),
+			  pipelineQueue
 		};
 		PointLightSystem pointLightSystem{
 			vulkanDevice,
 			vulkanRenderer.getSwapChainRenderPass(),
-			globalSetLayout->getDescriptorSetLayout() 
+			globalSetLayout->getDescriptorSetLayout(),
+			pipelineQueue
 		};
+		Tracer::setThreadName("Main");
 		KeyCommand keyCommand{};
 		VulkanCamera camera{};
 		 //camera.setViewDirection(glm::vec3(0.f), glm::vec3(0.5f, 0.f, 1.f));
@@ -87,24 +92,80 @@ namespace VulkanEngine {
 		auto viewerObject = VulkanGameObject::createGameObject(); // has no model, but will store camera's current state.
 		KeyboardMovementController gameController{};
 
-		glfwSetWindowUserPointer(vulkanWindow.getGLFWwindow(), &keyCommand);
-		glfwSetKeyCallback(vulkanWindow.getGLFWwindow(), key_callback);
+		// a benchmark takes no toggles, so a stray key press can't change its workload
+		if (!vulkanWindow.isHeadless() && !config.benchmark) {
+			glfwSetWindowUserPointer(vulkanWindow.getGLFWwindow(), &keyCommand);
+			glfwSetKeyCallback(vulkanWindow.getGLFWwindow(), key_callback);
+		}
 		
 		auto currentTime = std::chrono::high_resolution_clock::now();
+		const auto startTime = currentTime;
+		using Milliseconds = std::chrono::duration<double, std::milli>;
+
+		// a benchmark replays its input at a fixed timestep, so every run sees the same frames
+		CameraPath replayPath{};
+		if (config.benchmark) {
+			replayPath = config.cameraPath.empty() ? CameraPath::scripted() : CameraPath::load(config.cameraPath);
+		}
+		CameraPath recordedPath{};
+		Benchmark benchmark{};
+		auto lastFrameEnd = currentTime;
 		
 		// Initial Camera transformations
 		viewerObject.transform.translation = glm::vec3{ 0.f, 0.f, -16.f };
-		while (!vulkanWindow.shouldClose()) {
-			glfwPollEvents();
+		uint64_t frameCount = 0;
+		VkPresentModeKHR presentMode = config.presentMode;
+		if (!config.tracePath.empty()) {
+			startTrace();
+		}
+		while (!vulkanWindow.shouldClose() && (config.frameCount == 0 || frameCount < config.frameCount)) {
+			if (keyCommand.toggle_trace) {
+				keyCommand.toggle_trace = false;
+				if (Tracer::isEnabled()) {
+					stopTrace();
+				}
+				else {
+					startTrace();
+				}
+			}
+			TraceZone frameZone{ "Frame" };
+			const auto iterationStart = std::chrono::high_resolution_clock::now();
+			// before input is read, so a capped frame doesn't add to the input latency
+			{
+				TraceZone zone{ "FrameLimiter" };
+				frameLimiter.wait();
+			}
+			Milliseconds waitTime = std::chrono::high_resolution_clock::now() - iterationStart;
+			TraceZone inputZone{ "Input" };
+			vulkanWindow.pollEvents();
+			if (keyCommand.cycle_present_mode) {
+				// cycles through the requested modes, since unsupported ones fall back to one already seen
+				presentMode = nextPresentMode(presentMode);
+				vulkanRenderer.setPresentMode(presentMode);
+				keyCommand.cycle_present_mode = false;
+			}
 			// delta time
 			auto newTime = std::chrono::high_resolution_clock::now();
 			float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
 			currentTime = newTime;
+			if (config.fixedTimestep > 0.0) {
+				frameTime = static_cast<float>(config.fixedTimestep);
+			}
 
 			float aspect = vulkanRenderer.getAspectRatio();
 
 			// < Controller >
-			glm::vec3 inputDir = gameController.getInputDirection(vulkanWindow.getGLFWwindow(), frameTime, viewerObject);
+			uint32_t keys = 0;
+			if (config.benchmark) {
+				keys = replayPath.keysAt(frameCount);
+			}
+			else if (!vulkanWindow.isHeadless()) {
+				keys = KeyboardMovementController::pollKeys(vulkanWindow.getGLFWwindow());
+			}
+			if (!config.recordCameraPath.empty()) {
+				recordedPath.record(keys);
+			}
+			glm::vec3 inputDir = gameController.getInputDirection(keys, frameTime, viewerObject);
 			if (keyCommand.free_camera_mode == true) {
 				// < Controller.Camera Controller >
 				// Camera's Transformation
@@ -136,59 +197,326 @@ namespace VulkanEngine {
 				
 				camera.setPerspectiveProjection(0.67f, aspect, 0.1f, 10000.f);
 			}
+			inputZone.end();
 
-			if (auto commandBuffer = vulkanRenderer.beginFrame()) {
+			bool logMemoryStats = keyCommand.print_memory_stats;
+			bool logGpuTimings = keyCommand.print_gpu_timings;
+			const auto acquireStart = std::chrono::high_resolution_clock::now();
+			auto commandBuffer = vulkanRenderer.beginFrame();
+			waitTime += std::chrono::high_resolution_clock::now() - acquireStart;
+			if (commandBuffer) {
 				int frameIndex = vulkanRenderer.getFrameIndex();
+				auto uboSlice = frameAllocator.allocate(sizeof(GlobalUbo));
 				FrameInfo frameInfo{
 					frameIndex,
 					frameTime,
 					commandBuffer,
 					camera,
-					globalDescriptorSets[frameIndex],
+					globalDescriptorSet,
+					static_cast<uint32_t>(uboSlice.offset),
 					gameLightObjects,
 					gameMeshObjects,
-					gamePlayer
+					gamePlayer,
+					frameAllocator
 				};
+				VulkanCommandStats commandStats{};
+				frameInfo.commandStats = &commandStats;
+				gpuProfiler.beginFrame(commandBuffer, frameIndex);
+				uint32_t frameScope = gpuProfiler.beginScope(commandBuffer, "Frame");
 				// update
 				GlobalUbo ubo{};
 				ubo.projection = camera.getProjection();
 				ubo.view = camera.getView();
 				ubo.inverseView = camera.getInverseView();
-				ubo.t = (float) glfwGetTime();
-				//std::cout << "Time: " << (float) glfwGetTime() << "\n";
-				pointLightSystem.update(frameInfo, ubo);
-				playerSystem.update(frameInfo);
-				uboBuffers[frameIndex]->writeToBuffer(&ubo);
-				uboBuffers[frameIndex]->flush();
+				// timed here rather than by GLFW, which a headless run never initializes
+				ubo.t = config.fixedTimestep > 0.0
+					? static_cast<float>(frameCount * config.fixedTimestep)
+					: std::chrono::duration<float, std::chrono::seconds::period>(newTime - startTime).count();
+				{
+					TraceZone zone{ "PointLightSystem::update" };
+					pointLightSystem.update(frameInfo, ubo);
+				}
+				{
+					TraceZone zone{ "PlayerSystem::update" };
+					playerSystem.update(frameInfo);
+				}
+				{
+					TraceZone zone{ "UBO write" };
+					std::memcpy(uboSlice.data, &ubo, sizeof(GlobalUbo));
+				}
 				//std::cout << "Size of frameinfo: " << sizeof(FrameInfo) << "\n";
 				// render
-				vulkanRenderer.beginSwapChainRenderPass(commandBuffer);
-				simpleRenderSystem.renderGameObjects(frameInfo);
-				playerSystem.render(frameInfo);
-				//wireframeSystem.render(frameInfo);
-				pointLightSystem.render(frameInfo);
+				{
+					TraceZone zone{ "Defragmenter" };
+					VulkanGpuProfiler::Scope scope{ gpuProfiler, commandBuffer, "Defragmenter" };
+					defragmenter.recordFrame(commandBuffer);
+				}
+				bool secondary = keyCommand.parallel_recording || keyCommand.static_batching;
+				// a query can't stay active across secondary command buffers without inheritedQueries
+				bool pipelineStatistics = !secondary || vulkanDevice.isInheritedQueriesSupported();
+				if (pipelineStatistics) {
+					gpuProfiler.beginPipelineStatistics(commandBuffer);
+				}
+				if (secondary) {
+					vulkanRenderer.beginSwapChainRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+					renderSceneSecondary(frameInfo, keyCommand, simpleRenderSystem, playerSystem, pointLightSystem);
+				}
+				else {
+					vulkanRenderer.beginSwapChainRenderPass(commandBuffer);
+					geometryPool.bind(commandBuffer);
+					{
+						TraceZone zone{ "SimpleRenderSystem" };
+						VulkanGpuProfiler::Scope scope{ gpuProfiler, commandBuffer, "SimpleRenderSystem" };
+						simpleRenderSystem.renderGameObjects(frameInfo);
+					}
+					{
+						TraceZone zone{ "PlayerSystem" };
+						VulkanGpuProfiler::Scope scope{ gpuProfiler, commandBuffer, "PlayerSystem" };
+						playerSystem.render(frameInfo);
+					}
+					//wireframeSystem.render(frameInfo);
+					{
+						TraceZone zone{ "PointLightSystem" };
+						VulkanGpuProfiler::Scope scope{ gpuProfiler, commandBuffer, "PointLightSystem" };
+						pointLightSystem.render(frameInfo);
+					}
+				}
 				vulkanRenderer.endSwapChainRenderPass(commandBuffer);
-				vulkanRenderer.endFrame();
+				if (pipelineStatistics) {
+					gpuProfiler.endPipelineStatistics(commandBuffer);
+				}
+				gpuProfiler.endScope(commandBuffer, frameScope);
+				{
+					TraceZone zone{ "EndFrame" };
+					vulkanRenderer.endFrame();
+				}
+				frameCount++;
+				lastFrameCommandStats = commandStats;
+				if (config.benchmark) {
+					const auto frameEnd = std::chrono::high_resolution_clock::now();
+					benchmark.addFrame(
+						Milliseconds(frameEnd - lastFrameEnd).count(),
+						(Milliseconds(frameEnd - iterationStart) - waitTime).count());
+					lastFrameEnd = frameEnd;
+				}
+				logMemoryStats |= MEMORY_STATS_INTERVAL > 0 && frameCount % MEMORY_STATS_INTERVAL == 0;
+				logGpuTimings |= GPU_TIMINGS_INTERVAL > 0 && frameCount % GPU_TIMINGS_INTERVAL == 0;
+			}
+
+			// < Memory Stats >
+			if (logMemoryStats) {
+				VulkanMemoryStats memoryStats = vulkanDevice.getMemoryStats();
+				memoryStats.print(std::cout);
+				if (memoryStats.isOverBudget(0.9f)) {
+					std::cout << "WARNING: GPU memory usage is above 90% of the budget\n";
+				}
+				keyCommand.print_memory_stats = false;
+			}
+			// < GPU Timings >
+			if (logGpuTimings) {
+				gpuProfiler.printStats(std::cout);
+				lastFrameCommandStats.print(std::cout);
+				VulkanGpuProfiler::PipelineStatistics pipelineStatistics{};
+				if (gpuProfiler.getPipelineStatistics(pipelineStatistics)) {
+					pipelineStatistics.print(std::cout);
+				}
+				keyCommand.print_gpu_timings = false;
 			}
 		}
 		vkDeviceWaitIdle(vulkanDevice.device());
+		gpuProfiler.collectAll();
+		if (Tracer::isEnabled()) {
+			stopTrace();
+		}
+		if (!config.recordCameraPath.empty()) {
+			recordedPath.save(config.recordCameraPath);
+			std::cout << "Camera path written to " << config.recordCameraPath << "\n";
+		}
+		if (config.benchmark) {
+			benchmark.print(std::cout);
+			benchmark.writeReport(
+				config.benchmarkReport,
+				config,
+				{ vulkanDevice.properties.deviceName, vulkanRenderer.getPresentMode(), vulkanRenderer.getFramesInFlight() },
+				gpuProfiler);
+			std::cout << "Benchmark report written to " << config.benchmarkReport << "\n";
+		}
+	}
+
+	void FirstApp::startTrace()
+	{
+		gpuProfiler.calibrate();
+		Tracer::start();
+		std::cout << "Tracing started\n";
+	}
+
+	void FirstApp::stopTrace()
+	{
+		Tracer::stop();
+		const std::string path = config.tracePath.empty() ? EngineConfig::DEFAULT_TRACE_PATH : config.tracePath;
+		Tracer::writeChromeTrace(path);
+		std::cout << "Trace written to " << path << "\n";
 	}
 	
+	void FirstApp::renderSceneSecondary(
+		FrameInfo& frameInfo,
+		const KeyCommand& keyCommand,
+		SimpleRenderSystem& simpleRenderSystem,
+		PlayerSystem& playerSystem,
+		PointLightSystem& pointLightSystem)
+	{
+		meshObjectList.clear();
+		staticObjectList.clear();
+		for (auto& kv : frameInfo.gameMeshObjects) {
+			if (keyCommand.static_batching && kv.second.isStatic) {
+				staticObjectList.push_back(&kv.second);
+			}
+			else {
+				meshObjectList.push_back(&kv.second);
+			}
+		}
+
+		size_t objectCount = meshObjectList.size();
+		size_t taskCount = 0;
+		if (keyCommand.parallel_recording) {
+			taskCount = std::min<size_t>(
+				threadPool.size(), (objectCount + MIN_OBJECTS_PER_RECORDING_TASK - 1) / MIN_OBJECTS_PER_RECORDING_TASK);
+		}
+		size_t chunkSize = taskCount > 0 ? (objectCount + taskCount - 1) / taskCount : 0;
+
+		// execution order follows this vector: the static batch, mesh chunks, then the player and the lights
+		size_t firstTask = staticObjectList.empty() ? 0 : 1;
+		std::vector<VkCommandBuffer> secondaryCommandBuffers(firstTask + taskCount + 1);
+		// every recording counts into its own slot, so the workers never share one
+		slotCommandStats.assign(secondaryCommandBuffers.size(), VulkanCommandStats{});
+		if (!staticObjectList.empty()) {
+			secondaryCommandBuffers[0] = recordStaticBatch(frameInfo, simpleRenderSystem);
+			slotCommandStats[0] = staticBatchStats;
+		}
+		std::vector<std::future<void>> tasks;
+		/* The workers write into the locals above, so every submitted task has to finish before they
+			unwind, including when the recording on this thread throws. */
+		struct TaskWaiter {
+			std::vector<std::future<void>>& tasks;
+			~TaskWaiter() {
+				for (auto& task : tasks) {
+					if (task.valid()) {
+						task.wait();
+					}
+				}
+			}
+		} taskWaiter{ tasks };
+		for (size_t task = 0; task < taskCount; task++) {
+			tasks.push_back(threadPool.submit([&, task] {
+				FrameInfo chunkInfo = frameInfo;
+				chunkInfo.commandBuffer = vulkanRenderer.beginSecondaryCommandBuffer(static_cast<uint32_t>(task));
+				chunkInfo.commandStats = &slotCommandStats[firstTask + task];
+				geometryPool.bind(chunkInfo.commandBuffer);
+
+				size_t first = task * chunkSize;
+				size_t count = std::min(chunkSize, objectCount - first);
+				{
+					// the chunks add up to one SimpleRenderSystem sample
+					TraceZone zone{ "SimpleRenderSystem" };
+					VulkanGpuProfiler::Scope scope{ gpuProfiler, chunkInfo.commandBuffer, "SimpleRenderSystem" };
+					simpleRenderSystem.renderGameObjects(chunkInfo, meshObjectList.data() + first, count);
+				}
+
+				vulkanRenderer.endSecondaryCommandBuffer(chunkInfo.commandBuffer);
+				secondaryCommandBuffers[firstTask + task] = chunkInfo.commandBuffer;
+			}));
+		}
+
+		// this thread records the remaining systems in the meantime, through the last slot
+		FrameInfo systemsInfo = frameInfo;
+		systemsInfo.commandBuffer = vulkanRenderer.beginSecondaryCommandBuffer(threadPool.size());
+		systemsInfo.commandStats = &slotCommandStats[firstTask + taskCount];
+		geometryPool.bind(systemsInfo.commandBuffer);
+		if (taskCount == 0 && objectCount > 0) {
+			TraceZone zone{ "SimpleRenderSystem" };
+			VulkanGpuProfiler::Scope scope{ gpuProfiler, systemsInfo.commandBuffer, "SimpleRenderSystem" };
+			simpleRenderSystem.renderGameObjects(systemsInfo, meshObjectList.data(), objectCount);
+		}
+		{
+			TraceZone zone{ "PlayerSystem" };
+			VulkanGpuProfiler::Scope scope{ gpuProfiler, systemsInfo.commandBuffer, "PlayerSystem" };
+			playerSystem.render(systemsInfo);
+		}
+		{
+			TraceZone zone{ "PointLightSystem" };
+			VulkanGpuProfiler::Scope scope{ gpuProfiler, systemsInfo.commandBuffer, "PointLightSystem" };
+			pointLightSystem.render(systemsInfo);
+		}
+		vulkanRenderer.endSecondaryCommandBuffer(systemsInfo.commandBuffer);
+		secondaryCommandBuffers[firstTask + taskCount] = systemsInfo.commandBuffer;
+
+		// a worker's exception rethrows here; taskWaiter still waits for the tasks after it
+		for (auto& task : tasks) {
+			task.get();
+		}
+		if (frameInfo.commandStats) {
+			for (auto& stats : slotCommandStats) {
+				*frameInfo.commandStats += stats;
+			}
+		}
+		vulkanRenderer.executeSecondaryCommandBuffers(frameInfo.commandBuffer, secondaryCommandBuffers);
+	}
+
+	VkCommandBuffer FirstApp::recordStaticBatch(FrameInfo& frameInfo, SimpleRenderSystem& simpleRenderSystem)
+	{
+		// the draws also depend on the render pass and on where the geometry pool keeps their vertices and indices
+		staticBatchKey.clear();
+		simpleRenderSystem.addRecordingKey(
+			staticBatchKey, frameInfo, staticObjectList.data(), staticObjectList.size());
+		staticBatchKey.add(vulkanRenderer.getSwapChainRenderPass(), geometryPool.getVersion(),
+			geometryPool.getVertexBuffer().getBuffer(), geometryPool.getIndexBuffer().getBuffer());
+
+		// replayed across frames, so it can't hold this frame's queries; its time only shows in "Frame"
+		if (!vulkanRenderer.isCachedCommandBufferValid(staticBatchCommandBuffer, staticBatchKey)) {
+			TraceZone zone{ "Static batch" };
+			FrameInfo batchInfo = frameInfo;
+			batchInfo.commandBuffer = vulkanRenderer.beginCachedCommandBuffer(staticBatchCommandBuffer, staticBatchKey);
+			staticBatchStats = VulkanCommandStats{};
+			batchInfo.commandStats = &staticBatchStats;
+			geometryPool.bind(batchInfo.commandBuffer);
+			simpleRenderSystem.renderGameObjects(batchInfo, staticObjectList.data(), staticObjectList.size());
+			vulkanRenderer.endSecondaryCommandBuffer(batchInfo.commandBuffer);
+		}
+		return vulkanRenderer.getCachedCommandBuffer(staticBatchCommandBuffer);
+	}
+
+	VkPresentModeKHR FirstApp::nextPresentMode(VkPresentModeKHR presentMode)
+	{
+		switch (presentMode) {
+		case VK_PRESENT_MODE_FIFO_KHR:
+			return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+		case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+			return VK_PRESENT_MODE_MAILBOX_KHR;
+		case VK_PRESENT_MODE_MAILBOX_KHR:
+			return VK_PRESENT_MODE_IMMEDIATE_KHR;
+		default:
+			return VK_PRESENT_MODE_FIFO_KHR;
+		}
+	}
+
 	void FirstApp::loadGameObjects()
 	{
 		std::vector<VulkanModel::Vertex> retriever_of_vertices;
 		std::shared_ptr<VulkanModel> vulkanModel;
 		std::shared_ptr<VulkanModel> normalModel;
+		// every mesh goes up in a single submission
+		VulkanUploadBatch uploadBatch{ vulkanDevice.uploader() };
 
-		vulkanModel = VulkanModel::createModelFromEquation(vulkanDevice,
-			0, glm::vec3(0, 0, 1), -5, 5, -5, 5, 2, glm::vec3(0.6f, 0.25f, 0.25f), retriever_of_vertices);
+		vulkanModel = VulkanModel::createModelFromEquation(geometryPool,
+			0, glm::vec3(0, 0, 1), -5, 5, -5, 5, 2, glm::vec3(0.6f, 0.25f, 0.25f), retriever_of_vertices, &uploadBatch);
 		auto gameObj = VulkanGameObject::createGameObject();
 		gameObj.model = vulkanModel;
+		gameObj.isStatic = true;
 		gameObj.transform.translation = { 0, .0f, 0.f };
 		gameObj.transform.rotation = glm::vec3(0.f, 0.f, 0.0f);
 		gameMeshObjects.emplace(gameObj.getId(), std::move(gameObj));
 		
-		/*normalModel = VulkanModel::createNormalForModel(vulkanDevice, retriever_of_vertices);
+		/*normalModel = VulkanModel::createNormalForModel(geometryPool, retriever_of_vertices, &uploadBatch);
 		gameObj = VulkanGameObject::createGameObject();
 		gameObj.model = normalModel;
 		gameObj.transform.translation = { 0.f, .0f, 0.f };
@@ -196,15 +524,16 @@ namespace VulkanEngine {
 		gameWireframeObjects.emplace(gameObj.getId(), std::move(gameObj));*/
 
 		//
-		vulkanModel = VulkanModel::createModelFromEquation(vulkanDevice,
-			0, glm::vec3(0, 0, 1), -5, 5, -5, 5, 2, glm::vec3(0.25f, 0.6f, 0.25f), retriever_of_vertices);
+		vulkanModel = VulkanModel::createModelFromEquation(geometryPool,
+			0, glm::vec3(0, 0, 1), -5, 5, -5, 5, 2, glm::vec3(0.25f, 0.6f, 0.25f), retriever_of_vertices, &uploadBatch);
 		gameObj = VulkanGameObject::createGameObject();
 		gameObj.model = vulkanModel;
+		gameObj.isStatic = true;
 		gameObj.transform.translation = { 0.f, .0f, 0.f };
 		gameObj.transform.rotation = glm::vec3( 0.f, 0.f, M_PI_2);
 		gameMeshObjects.emplace(gameObj.getId(), std::move(gameObj));
 
-		/*normalModel = VulkanModel::createNormalForModel(vulkanDevice, retriever_of_vertices);
+		/*normalModel = VulkanModel::createNormalForModel(geometryPool, retriever_of_vertices, &uploadBatch);
 		gameObj = VulkanGameObject::createGameObject();
 		gameObj.model = normalModel;
 		gameObj.transform.translation = { 0.f, .0f, 0.f };
@@ -212,15 +541,16 @@ namespace VulkanEngine {
 		gameWireframeObjects.emplace(gameObj.getId(), std::move(gameObj));*/
 
 		//
-		vulkanModel = VulkanModel::createModelFromEquation(vulkanDevice,
-			0, glm::vec3(0, 0, 1.f), -5, 5, -5, 5, 2, glm::vec3(0.25f, 0.25f, 0.6f), retriever_of_vertices);
+		vulkanModel = VulkanModel::createModelFromEquation(geometryPool,
+			0, glm::vec3(0, 0, 1.f), -5, 5, -5, 5, 2, glm::vec3(0.25f, 0.25f, 0.6f), retriever_of_vertices, &uploadBatch);
 		gameObj = VulkanGameObject::createGameObject();
 		gameObj.model = vulkanModel;
+		gameObj.isStatic = true;
 		gameObj.transform.translation = { 0.f, .0f, 0.f };
 		gameObj.transform.rotation = glm::vec3(M_PI_2, 0.f, 0.0f);
 		gameMeshObjects.emplace(gameObj.getId(), std::move(gameObj));
 
-		/*normalModel = VulkanModel::createNormalForModel(vulkanDevice, retriever_of_vertices);
+		/*normalModel = VulkanModel::createNormalForModel(geometryPool, retriever_of_vertices, &uploadBatch);
 		gameObj = VulkanGameObject::createGameObject();
 		gameObj.model = normalModel;
 		gameObj.transform.translation = { 0.f, .0f, 0.f };
@@ -229,10 +559,11 @@ namespace VulkanEngine {
 		gameWireframeObjects.emplace(gameObj.getId(), std::move(gameObj));*/
 		
 		// Player cube
-		vulkanModel = VulkanModel::createModelFromFile(vulkanDevice, "assets/colored_cube.obj");
+		vulkanModel = VulkanModel::createModelFromFile(geometryPool, "assets/colored_cube.obj", &uploadBatch);
 		gamePlayer.model = vulkanModel;
 		gamePlayer.transform.translation = { 0.0f, 0.0f, 0.f };
 		gamePlayer.transform.scale = glm::vec3(3.f);
+		vulkanRenderer.waitForUpload(uploadBatch.submit());
 
 
 		std::vector<glm::vec3> lightColors{
@@ -273,6 +604,36 @@ namespace VulkanEngine {
 				}
 				break;
 			}
+			case GLFW_KEY_M: {
+				KeyCommand* key = static_cast<KeyCommand*>(glfwGetWindowUserPointer(window));
+				key->print_memory_stats = true;
+				break;
+			}
+			case GLFW_KEY_P: {
+				KeyCommand* key = static_cast<KeyCommand*>(glfwGetWindowUserPointer(window));
+				key->parallel_recording = !key->parallel_recording;
+				break;
+			}
+			case GLFW_KEY_V: {
+				KeyCommand* key = static_cast<KeyCommand*>(glfwGetWindowUserPointer(window));
+				key->cycle_present_mode = true;
+				break;
+			}
+			case GLFW_KEY_G: {
+				KeyCommand* key = static_cast<KeyCommand*>(glfwGetWindowUserPointer(window));
+				key->print_gpu_timings = true;
+				break;
+			}
+			case GLFW_KEY_T: {
+				KeyCommand* key = static_cast<KeyCommand*>(glfwGetWindowUserPointer(window));
+				key->toggle_trace = true;
+				break;
+			}
+			case GLFW_KEY_B: {
+				KeyCommand* key = static_cast<KeyCommand*>(glfwGetWindowUserPointer(window));
+				key->static_batching = !key->static_batching;
+				break;
+			}
 			}
 		}
 	}
@@ -2,27 +2,50 @@
 
 #include "keyboard_movement_controller.h"
 
+#include "Benchmark.h"
+#include "CameraPath.h"
+#include "EngineConfig.h"
+#include "FrameLimiter.h"
 #include "VulkanDevice.h"
 #include "VulkanWindow.h"
 #include "VulkanGameObject.h"
 #include "VulkanRenderer.h"
 #include "VulkanBuffer.h"
 #include "VulkanDescriptors.h"
+#include "VulkanFrameInfo.h"
+#include "VulkanGeometryPool.h"
+#include "VulkanGpuProfiler.h"
+#include "VulkanDefragmenter.h"
+#include "VulkanThreadPool.h"
 
 // std
+#include <algorithm>
 #include <memory>
 #include <vector>
 namespace VulkanEngine {
+	class SimpleRenderSystem;
+	class PlayerSystem;
+	class PointLightSystem;
+
 	class FirstApp {
 	public:
 		struct KeyCommand {
 			bool free_camera_mode = true;
+			bool print_memory_stats = false;
+			bool parallel_recording = false;
+			bool static_batching = false;
+			bool cycle_present_mode = false;
+			bool print_gpu_timings = false;
+			bool toggle_trace = false;
 		};
 
 		static constexpr int WIDTH = 1280;
 		static constexpr int HEIGHT = 720;
+		static constexpr int MEMORY_STATS_INTERVAL = 1000; // frames between memory stats logs, 0 = only on M key
+		static constexpr int GPU_TIMINGS_INTERVAL = 1000; // frames between GPU timing and command stats logs, 0 = only on G key
+		static constexpr size_t MIN_OBJECTS_PER_RECORDING_TASK = 256; // smaller chunks cost more than they save
 
-		FirstApp();
+		FirstApp(const EngineConfig& engineConfig = {});
 		~FirstApp();
 
 		FirstApp(const FirstApp&) = delete; // deleting copy constructors
@@ -33,17 +56,53 @@ namespace VulkanEngine {
 
 		// Simple Render System - Anything that acts upon a subset of a game object components is a system
 		void loadGameObjects();
-		VulkanWindow vulkanWindow{ WIDTH, HEIGHT, "Hello Vulkan!" };
+		/* Records the scene into secondary command buffers: static objects replay a cached one
+			(B key toggles), the rest is spread over the thread pool (P key toggles) */
+		void renderSceneSecondary(
+			FrameInfo& frameInfo,
+			const KeyCommand& keyCommand,
+			SimpleRenderSystem& simpleRenderSystem,
+			PlayerSystem& playerSystem,
+			PointLightSystem& pointLightSystem);
+		// This frame's cached recording of staticObjectList, re-recorded only if something it draws changed
+		VkCommandBuffer recordStaticBatch(FrameInfo& frameInfo, SimpleRenderSystem& simpleRenderSystem);
+		// T key or --trace: captures CPU zones and GPU scopes until stopTrace writes them out
+		void startTrace();
+		void stopTrace();
+		EngineConfig config;
+		VulkanWindow vulkanWindow{ WIDTH, HEIGHT, "Hello Vulkan!", config.headless };
 		VulkanDevice vulkanDevice{ vulkanWindow };
-		VulkanRenderer vulkanRenderer{ vulkanWindow, vulkanDevice };
+		VulkanRenderer vulkanRenderer{
+			vulkanWindow, vulkanDevice, config.framesInFlight, config.minImageCount, config.presentMode };
+		// a benchmark reports GPU times over the whole run, so the history has to hold every frame
+		VulkanGpuProfiler gpuProfiler{
+			vulkanDevice,
+			vulkanRenderer.getFramesInFlight(),
+			VulkanGpuProfiler::DEFAULT_MAX_SCOPES,
+			config.benchmark
+				? std::max<size_t>(config.frameCount, VulkanGpuProfiler::DEFAULT_HISTORY_LENGTH)
+				: VulkanGpuProfiler::DEFAULT_HISTORY_LENGTH };
+		FrameLimiter frameLimiter{ config.maxFps };
+		VulkanThreadPool threadPool{};
 		static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+		// V key: FIFO -> FIFO relaxed -> mailbox -> immediate -> FIFO
+		static VkPresentModeKHR nextPresentMode(VkPresentModeKHR presentMode);
 		//static bool free_camera_mode = false;
 		// note: order of declarations matters
 		std::unique_ptr<VulkanDescriptorPool> globalPool{};
+		VulkanGeometryPool geometryPool{ vulkanDevice }; // must outlive every model
+		VulkanDefragmenter defragmenter{ vulkanDevice, vulkanRenderer.getFramesInFlight() };
 		VulkanGameObject::Map gameMeshObjects;
 		VulkanGameObject::Map gameWireframeObjects;
 		VulkanGameObject::Map gameLightObjects;
 		VulkanGameObject gamePlayer = VulkanGameObject::createGameObject();
+		std::vector<VulkanGameObject*> meshObjectList; // scratch for splitting gameMeshObjects into chunks
+		std::vector<VulkanGameObject*> staticObjectList; // scratch for the static part of gameMeshObjects
+		uint32_t staticBatchCommandBuffer = 0;
+		RecordingKey staticBatchKey{};                    // rebuilt every frame, compared against the cached one
+		VulkanCommandStats staticBatchStats{};            // what the cached static batch holds, added every frame it runs
+		std::vector<VulkanCommandStats> slotCommandStats; // per secondary command buffer, summed after recording
+		VulkanCommandStats lastFrameCommandStats{};
 
 	};
 }
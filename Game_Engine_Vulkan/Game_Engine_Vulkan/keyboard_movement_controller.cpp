@@ -4,13 +4,29 @@
 #include <iostream>
 
 namespace VulkanEngine {
-	glm::vec3 KeyboardMovementController::getInputDirection(GLFWwindow* window, float dt, VulkanGameObject& gameObject)
+	uint32_t KeyboardMovementController::pollKeys(GLFWwindow* window)
+	{
+		uint32_t keys = 0;
+		if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) keys |= LOOK_RIGHT;
+		if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) keys |= LOOK_LEFT;
+		if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) keys |= LOOK_UP;
+		if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) keys |= LOOK_DOWN;
+		if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) keys |= MOVE_FORWARD;
+		if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) keys |= MOVE_BACKWARD;
+		if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) keys |= MOVE_RIGHT;
+		if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) keys |= MOVE_LEFT;
+		if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS) keys |= MOVE_UP;
+		if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS) keys |= MOVE_DOWN;
+		return keys;
+	}
+
+	glm::vec3 KeyboardMovementController::getInputDirection(uint32_t keys, float dt, VulkanGameObject& gameObject)
 	{
 		glm::vec3 rotate{ 0 };
-		if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) rotate.y += 1.f;
-		if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) rotate.y -= 1.f;
-		if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) rotate.x += 1.f;
-		if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) rotate.x -= 1.f;
+		if (keys & LOOK_RIGHT) rotate.y += 1.f;
+		if (keys & LOOK_LEFT) rotate.y -= 1.f;
+		if (keys & LOOK_UP) rotate.x += 1.f;
+		if (keys & LOOK_DOWN) rotate.x -= 1.f;
 
 		if (glm::dot(rotate, rotate) > std::numeric_limits<float>::epsilon()) {
 			gameObject.transform.rotation += lookSpeed * dt * glm::normalize(rotate);
@@ -26,12 +42,12 @@ namespace VulkanEngine {
 		const glm::vec3 upDir{ 0.f, -1.f, 0.f };
 
 		glm::vec3 moveDir{ 0.f };
-		if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) moveDir += forwardDir;
-		if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) moveDir -= forwardDir;
-		if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) moveDir += rightDir;
-		if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) moveDir -= rightDir;
-		if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS) moveDir += upDir;
-		if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS) moveDir -= upDir;
+		if (keys & MOVE_FORWARD) moveDir += forwardDir;
+		if (keys & MOVE_BACKWARD) moveDir -= forwardDir;
+		if (keys & MOVE_RIGHT) moveDir += rightDir;
+		if (keys & MOVE_LEFT) moveDir -= rightDir;
+		if (keys & MOVE_UP) moveDir += upDir;
+		if (keys & MOVE_DOWN) moveDir -= upDir;
 
 		return moveDir;
 	}
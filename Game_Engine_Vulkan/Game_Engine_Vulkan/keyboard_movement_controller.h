@@ -6,7 +6,25 @@
 namespace VulkanEngine {
 	class KeyboardMovementController {
 	public:
-		glm::vec3 getInputDirection(GLFWwindow* window, float dt, VulkanGameObject& gameObject);
+		// Held keys as a bitmask, so input can be recorded and replayed (see CameraPath)
+		enum Key : uint32_t {
+			LOOK_RIGHT = 1 << 0,
+			LOOK_LEFT = 1 << 1,
+			LOOK_UP = 1 << 2,
+			LOOK_DOWN = 1 << 3,
+			MOVE_FORWARD = 1 << 4,
+			MOVE_BACKWARD = 1 << 5,
+			MOVE_RIGHT = 1 << 6,
+			MOVE_LEFT = 1 << 7,
+			MOVE_UP = 1 << 8,
+			MOVE_DOWN = 1 << 9
+		};
+
+		static uint32_t pollKeys(GLFWwindow* window);
+		glm::vec3 getInputDirection(uint32_t keys, float dt, VulkanGameObject& gameObject);
+		glm::vec3 getInputDirection(GLFWwindow* window, float dt, VulkanGameObject& gameObject) {
+			return getInputDirection(pollKeys(window), dt, gameObject);
+		}
 		void moveInPlaneXZ(glm::vec3 moveDir, float dt, VulkanGameObject& gameObject);
 		void physics(float dt, VulkanGameObject& gameObject);
 
@@ -1,13 +1,19 @@
 #include "first_app.h"
+#include "EngineConfig.h"
+#include "VulkanMemoryAllocator.h"
 
 // std
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
 
-int main() {
-	VulkanEngine::FirstApp app;
+int main(int argc, char** argv) {
 	try {
+		VulkanEngine::EngineConfig config = VulkanEngine::EngineConfig::fromCommandLine(argc, argv);
+		if (config.allocatorSelfTest) {
+			return VulkanEngine::VulkanMemoryAllocator::runSelfTest(std::cout) ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+		VulkanEngine::FirstApp app{ config };
 		app.run();
 	}
 	catch (const std::exception &e) {